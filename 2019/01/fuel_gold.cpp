@@ -1,4 +1,16 @@
-#include <stdio.h>
+#include <cstdint>
+#include <cstdio>
+
+#include "lib.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define HAVE_AVX2_KERNEL 1
+#endif
+
+// Masses are parsed and summed in batches of this many modules, so inputs
+// of any size run in constant memory.
+#define BATCH 4096
 
 int fuel_for_mass(int mass) {
   int fuel = mass / 3 - 2;
@@ -8,22 +20,115 @@ int fuel_for_mass(int mass) {
   return 0;
 }
 
+// Fuel for the mass, plus fuel for that fuel, until it reaches zero.
 int fuel_for_mass_recursive(int mass) {
-  int fuel = fuel_for_mass(mass);
-  if (fuel == 0) {
-    return 0;
+  int total = 0;
+  for (int fuel = fuel_for_mass(mass); fuel > 0; fuel = fuel_for_mass(fuel)) {
+    total += fuel;
+  }
+  return total;
+}
+
+struct FuelSums {
+  long long modules = 0;  // fuel for the modules alone (part 1)
+  long long total = 0;    // including fuel for the fuel (part 2)
+};
+
+void addScalar(const int32_t *mass, int n, FuelSums *sums) {
+  for (int i = 0; i < n; i++) {
+    sums->modules += fuel_for_mass(mass[i]);
+    sums->total += fuel_for_mass_recursive(mass[i]);
+  }
+}
+
+#ifdef HAVE_AVX2_KERNEL
+// max(x / 3 - 2, 0) for 8 non-negative lanes. There is no vector integer
+// division, so x / 3 is (x * 0xAAAAAAAB) >> 33 on the even and odd 32-bit
+// lanes separately.
+__attribute__((target("avx2"))) static inline __m256i fuelStep(__m256i x) {
+  const __m256i magic = _mm256_set1_epi32((int)0xAAAAAAAB);
+  __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(x, magic), 33);
+  __m256i odd = _mm256_srli_epi64(
+      _mm256_mul_epu32(_mm256_srli_epi64(x, 32), magic), 33);
+  __m256i q = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+  return _mm256_max_epi32(_mm256_sub_epi32(q, _mm256_set1_epi32(2)),
+                          _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2"))) static inline void addWide(__m256i v,
+                                                           __m256i *acc) {
+  acc[0] = _mm256_add_epi64(acc[0],
+                            _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+  acc[1] = _mm256_add_epi64(
+      acc[1], _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+}
+
+__attribute__((target("avx2"))) static inline long long hsum(const __m256i *acc) {
+  __m256i v = _mm256_add_epi64(acc[0], acc[1]);
+  long long lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, v);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+// 16 masses per step in two vectors. The fuel-of-fuel loop runs until every
+// lane is zero; lanes that finish early stay at zero and add nothing. The
+// per-step totals fit in 32 bits (fuel < mass / 2) and are widened to 64
+// bits once per step. Returns how many masses were processed.
+__attribute__((target("avx2"))) int addAVX2(const int32_t *mass, int n,
+                                            FuelSums *sums) {
+  __m256i modules[2] = {_mm256_setzero_si256(), _mm256_setzero_si256()};
+  __m256i total[2] = {_mm256_setzero_si256(), _mm256_setzero_si256()};
+
+  int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i a = fuelStep(_mm256_loadu_si256((const __m256i *)(mass + i)));
+    __m256i b = fuelStep(_mm256_loadu_si256((const __m256i *)(mass + i + 8)));
+    __m256i first = _mm256_add_epi32(a, b);
+    __m256i sum = first;
+    while (!_mm256_testz_si256(_mm256_or_si256(a, b), _mm256_or_si256(a, b))) {
+      a = fuelStep(a);
+      b = fuelStep(b);
+      sum = _mm256_add_epi32(sum, _mm256_add_epi32(a, b));
+    }
+    addWide(first, modules);
+    addWide(sum, total);
   }
-  return fuel + fuel_for_mass_recursive(fuel);
+  sums->modules += hsum(modules);
+  sums->total += hsum(total);
+  return i;
 }
+#endif
 
+// Usage: ./a.out < in
 int main() {
-  long long fuel_sum = 0;
-  int mass = 0;
-  while (scanf("%d", &mass) == 1) {
-    int fuel = fuel_for_mass_recursive(mass);
-    fuel_sum += fuel;
+  Input input;
+  NumberScanner scanner(input.text());
+
+#ifdef HAVE_AVX2_KERNEL
+  const bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+  FuelSums sums;
+  static int32_t batch[BATCH];
+  for (;;) {
+    int n = 0;
+    while (n < BATCH && scanner.next(&batch[n])) {
+      n++;
+    }
+    if (n == 0) {
+      break;
+    }
+    int i = 0;
+#ifdef HAVE_AVX2_KERNEL
+    if (avx2) {
+      i = addAVX2(batch, n, &sums);
+    }
+#endif
+    addScalar(batch + i, n - i, &sums);
   }
-  printf("%lld\n", fuel_sum);
+
+  printf("modules: %lld\n", sums.modules);
+  printf("total: %lld\n", sums.total);
 
   return 0;
 }
@@ -1,6 +1,13 @@
 #include <cassert>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#define MAX_MEM 1000
+#define TARGET 19690720
 
 int run(int *mem, int len, int noun, int verb) {
   mem[1] = noun;
@@ -40,14 +47,166 @@ int run(int *mem, int len, int noun, int verb) {
   return mem[0];
 }
 
-int main() {
-  const int MAX_MEM = 1000;
+// Value of a memory cell as c0 + cn * noun + cv * verb + cnv * noun * verb,
+// or unknown when it depends on the inputs in any other way.
+struct Expr {
+  static Expr constant(long long c) { return Expr{true, c, 0, 0, 0}; }
+  static Expr unknown() { return Expr{false, 0, 0, 0, 0}; }
 
-  int prog[MAX_MEM];
-  int mem[MAX_MEM];
+  bool isConstant() const { return known && cn == 0 && cv == 0 && cnv == 0; }
+  bool onlyNoun() const { return known && cv == 0 && cnv == 0; }
+  bool onlyVerb() const { return known && cn == 0 && cnv == 0; }
+
+  Expr operator+(const Expr &o) const {
+    if (!known || !o.known) {
+      return unknown();
+    }
+    return Expr{true, c0 + o.c0, cn + o.cn, cv + o.cv, cnv + o.cnv};
+  }
+
+  Expr scaled(long long k) const {
+    return Expr{known, c0 * k, cn * k, cv * k, cnv * k};
+  }
+
+  Expr operator*(const Expr &o) const {
+    if (!known || !o.known) {
+      return unknown();
+    }
+    if (isConstant()) {
+      return o.scaled(c0);
+    }
+    if (o.isConstant()) {
+      return scaled(o.c0);
+    }
+    // (a0 + an * noun) * (b0 + bv * verb) is still bilinear
+    const Expr *a = this;
+    const Expr *b = &o;
+    if (!a->onlyNoun()) {
+      std::swap(a, b);
+    }
+    if (a->onlyNoun() && b->onlyVerb()) {
+      return Expr{true, a->c0 * b->c0, a->cn * b->c0, a->c0 * b->cv,
+                  a->cn * b->cv};
+    }
+    return unknown();
+  }
+
+  bool known;
+  long long c0;
+  long long cn;
+  long long cv;
+  long long cnv;
+};
+
+// Runs the program once with mem[1] and mem[2] as variables. Fails if the
+// control flow or any written address depends on them (an opcode or
+// destination cell that is not a constant). Reads through a symbolic address
+// only poison the value read, which is fine as long as it never reaches
+// mem[0] (Day 2 programs overwrite such cells before using them).
+bool evalSymbolic(const int *prog, int len, Expr *out) {
+  std::vector<Expr> mem(len);
+  for (int i = 0; i < len; i++) {
+    mem[i] = Expr::constant(prog[i]);
+  }
+  mem[1] = Expr{true, 0, 1, 0, 0};
+  mem[2] = Expr{true, 0, 0, 1, 0};
+
+  auto address = [&](int cell, int *addr) {
+    if (cell >= len || !mem[cell].isConstant()) {
+      return false;
+    }
+    *addr = (int)mem[cell].c0;
+    return *addr >= 0 && *addr < len;
+  };
+
+  for (int pc = 0; pc < len; pc += 4) {
+    if (!mem[pc].isConstant()) {
+      return false;
+    }
+    int opcode = (int)mem[pc].c0;
+    if (opcode == 99) {
+      *out = mem[0];
+      return out->known;
+    }
+    if (opcode != 1 && opcode != 2) {
+      continue;
+    }
+    int addr_dest;
+    if (!address(pc + 3, &addr_dest)) {
+      return false;
+    }
+    int addr_a;
+    int addr_b;
+    if (!address(pc + 1, &addr_a) || !address(pc + 2, &addr_b)) {
+      mem[addr_dest] = Expr::unknown();
+      continue;
+    }
+    const Expr &a = mem[addr_a];
+    const Expr &b = mem[addr_b];
+    mem[addr_dest] = (opcode == 1) ? a + b : a * b;
+  }
+  return false;  // no halt
+}
+
+// For each noun, the first verb such that the result is the target, or -1.
+// A bilinear result is solved per noun in closed form:
+//   (cv + cnv * noun) * verb = target - c0 - cn * noun
+void solve(const Expr &e, long long target, int *verb_for_noun) {
+  for (int noun = 0; noun < 100; noun++) {
+    long long rhs = target - e.c0 - e.cn * noun;
+    long long k = e.cv + e.cnv * noun;
+    verb_for_noun[noun] = -1;
+    if (k == 0) {
+      if (rhs == 0) {
+        verb_for_noun[noun] = 0;
+      }
+    } else if (rhs % k == 0 && rhs / k >= 0 && rhs / k < 100) {
+      verb_for_noun[noun] = (int)(rhs / k);
+    }
+  }
+}
+
+// Fallback: tries every pair, nouns split across threads.
+void search(const int *prog, int len, long long target, int *verb_for_noun) {
+  int num_threads = (int)std::thread::hardware_concurrency();
+  if (num_threads < 1) {
+    num_threads = 1;
+  }
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([=] {
+      int mem[MAX_MEM];
+      for (int noun = t; noun < 100; noun += num_threads) {
+        verb_for_noun[noun] = -1;
+        for (int verb = 0; verb < 100; verb++) {
+          memcpy(mem, prog, MAX_MEM * sizeof(mem[0]));
+          if (run(mem, len, noun, verb) == target) {
+            verb_for_noun[noun] = verb;
+            break;
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+// Usage: ./a.out [target] [search] < in
+int main(int argc, char *argv[]) {
+  long long target = TARGET;
+  bool force_search = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "search") == 0) {
+      force_search = true;
+    } else {
+      target = atoll(argv[i]);
+    }
+  }
 
+  int prog[MAX_MEM];
   memset(prog, 0, sizeof(prog));
-  memset(mem, 0, sizeof(mem));
 
   int len = 0;
   while (scanf("%d", &prog[len++])) {
@@ -59,14 +218,19 @@ int main() {
     }
   }
 
+  int verb_for_noun[100];
+  Expr result;
+  if (!force_search && evalSymbolic(prog, len, &result)) {
+    printf("mem[0] = %lld + %lld*noun + %lld*verb + %lld*noun*verb\n",
+           result.c0, result.cn, result.cv, result.cnv);
+    solve(result, target, verb_for_noun);
+  } else {
+    search(prog, len, target, verb_for_noun);
+  }
+
   for (int noun = 0; noun < 100; noun++) {
-    for (int verb = 0; verb < 100; verb++) {
-      memcpy(mem, prog, MAX_MEM * sizeof(mem[0]));
-      int result = run(mem, len, noun, verb);
-      if (result == 19690720) {
-        printf("%d %d -> %d\n", noun, verb, result);
-        break;
-      }
+    if (verb_for_noun[noun] >= 0) {
+      printf("%d %d -> %lld\n", noun, verb_for_noun[noun], target);
     }
   }
 
@@ -1,18 +1,16 @@
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
-#include <cstring>
+#include <cstdlib>
 #include <limits>
-#include <unordered_map>
+#include <set>
+#include <utility>
 #include <vector>
 
 #include "lib.h"
 
 using namespace std;
 
-#define MAXD 20000
-#define POSITIVE '+'
-#define NEGATIVE '-'
-
 Vec direction(char d) {
   switch (d) {
   case 'U':
@@ -28,91 +26,170 @@ Vec direction(char d) {
   return Vec();
 }
 
-struct Grid {
-  Grid() : _cursor(0, 0) { memset(_grid, '.', sizeof(_grid)); }
+// An axis-aligned piece of a wire, from (x0, y0) to (x1, y1). Coordinates
+// are 64-bit, so wires can be millions of units long per segment.
+struct Segment {
+  long long x0, y0;
+  long long x1, y1;
+  long long steps;  // wire length walked before (x0, y0)
+  int wire;
 
-  char &cell(int x, int y) {
-    int i = y + MAXD;
-    int j = x + MAXD;
-    if (i < 0 || i > 2 * MAXD) {
-      printf("%d\n", i);
-      assert(false);
-    }
-    if (j < 0 || i > 2 * MAXD) {
-      printf("%d\n", j);
-      assert(false);
-    }
-    return _grid[i][j];
-  }
+  bool horizontal() const { return y0 == y1; }
 
-  char &cell(Vec p) { return cell(p.x, p.y); }
+  long long minX() const { return min(x0, x1); }
+  long long maxX() const { return max(x0, x1); }
+  long long minY() const { return min(y0, y1); }
+  long long maxY() const { return max(y0, y1); }
 
-  void drawFromInput(char wire) {
-    _cursor = Vec(0, 0);
+  // total steps of the wire when it reaches (x, y) on this segment
+  long long stepsTo(long long x, long long y) const {
+    return steps + llabs(x - x0) + llabs(y - y0);
+  }
+};
 
-    for (;;) {
-      char d;
-      int steps;
-      scanf("%c%d", &d, &steps);
-      char c = getchar();
-      Vec dir = direction(d);
-      drawSegment(wire, dir, steps);
-      if (c == '\n' || c == EOF) {
-        break;
-      } else {
-        assert(c == ',');
-      }
+struct Crossings {
+  long long min_dist = numeric_limits<long long>::max();
+  long long min_total_steps = numeric_limits<long long>::max();
+
+  void add(long long x, long long y, const Segment &a, const Segment &b) {
+    if (x == 0 && y == 0) {
+      return;
     }
+    min_dist = min(min_dist, llabs(x) + llabs(y));
+    min_total_steps = min(min_total_steps, a.stepsTo(x, y) + b.stepsTo(x, y));
   }
+};
 
-  void drawSegment(char wire, Vec dir, int steps) {
-    auto &total_steps_map =
-        wire == POSITIVE ? _total_steps_positive : _total_steps_negative;
-
-    for (int k = 0; k < steps; k++) {
-      auto total_steps = total_steps_map[_cursor];
-      _cursor += dir;
+void readWire(int wire, vector<Segment> &segments) {
+  long long x = 0, y = 0, steps = 0;
+  for (;;) {
+    char d;
+    long long len;
+    if (scanf("%c%lld", &d, &len) != 2) {
+      break;
+    }
+    Vec dir = direction(d);
+    segments.push_back(
+        Segment{x, y, x + dir.x * len, y + dir.y * len, steps, wire});
+    x += dir.x * len;
+    y += dir.y * len;
+    steps += len;
+
+    int c = getchar();
+    if (c == '\n' || c == EOF) {
+      break;
+    } else {
+      assert(c == ',');
+    }
+  }
+}
 
-      if (cell(_cursor) != '.' && cell(_cursor) != wire) {
-        _crosses.push_back(_cursor);
-        cell(_cursor) = 'x';
-      } else {
-        cell(_cursor) = wire;
+// Sweeps the plane bottom to top keeping the verticals that span the current
+// row in a balanced tree ordered by x. Each horizontal queries the tree for
+// the verticals within its x range. O(s log s + crossings).
+void perpendicularCrossings(const vector<Segment> &segments, Crossings &out) {
+  enum { INSERT = 0, QUERY = 1, REMOVE = 2 };  // order of events in a row
+  struct Event {
+    long long y;
+    int kind;
+    int seg;
+  };
+  vector<Event> events;
+  for (int i = 0; i < (int)segments.size(); i++) {
+    auto &s = segments[i];
+    if (s.horizontal()) {
+      events.push_back(Event{s.y0, QUERY, i});
+    } else {
+      events.push_back(Event{s.minY(), INSERT, i});
+      events.push_back(Event{s.maxY(), REMOVE, i});
+    }
+  }
+  sort(events.begin(), events.end(), [](const Event &a, const Event &b) {
+    return a.y < b.y || (a.y == b.y && a.kind < b.kind);
+  });
+
+  set<pair<long long, int>> active;  // (x, segment)
+  for (auto &e : events) {
+    auto &s = segments[e.seg];
+    if (e.kind == INSERT) {
+      active.emplace(s.x0, e.seg);
+    } else if (e.kind == REMOVE) {
+      active.erase(make_pair(s.x0, e.seg));
+    } else {
+      auto it = active.lower_bound(make_pair(s.minX(), -1));
+      for (; it != active.end() && it->first <= s.maxX(); ++it) {
+        auto &v = segments[it->second];
+        if (v.wire != s.wire) {
+          out.add(v.x0, s.y0, s, v);
+        }
       }
-
-      total_steps_map[_cursor] = total_steps + 1;
     }
   }
+}
 
-  char _grid[MAXD + 1 + MAXD][MAXD + 1 + MAXD];
-  Vec _cursor;
-  vector<Vec> _crosses;
-  unordered_map<Vec, int> _total_steps_negative;
-  unordered_map<Vec, int> _total_steps_positive;
-};
-
-Grid grid;
+// Parallel segments of different wires that overlap on the same line. The
+// distance and the combined steps are both piecewise linear along the
+// overlap, so only its ends and the points closest to the origin matter
+// (the origin itself never counts).
+void collinearCrossings(const vector<Segment> &segments, Crossings &out) {
+  // (line, start, end, segment) with the line being y for horizontals and x
+  // for verticals
+  struct Span {
+    bool horizontal;
+    long long line, lo, hi;
+    int seg;
+  };
+  vector<Span> spans;
+  for (int i = 0; i < (int)segments.size(); i++) {
+    auto &s = segments[i];
+    if (s.horizontal()) {
+      spans.push_back(Span{true, s.y0, s.minX(), s.maxX(), i});
+    } else {
+      spans.push_back(Span{false, s.x0, s.minY(), s.maxY(), i});
+    }
+  }
+  sort(spans.begin(), spans.end(), [](const Span &a, const Span &b) {
+    return make_pair(a.horizontal, make_pair(a.line, a.lo)) <
+           make_pair(b.horizontal, make_pair(b.line, b.lo));
+  });
+
+  for (size_t i = 0; i < spans.size(); i++) {
+    auto &a = spans[i];
+    for (size_t j = i + 1; j < spans.size(); j++) {
+      auto &b = spans[j];
+      if (b.horizontal != a.horizontal || b.line != a.line || b.lo > a.hi) {
+        break;
+      }
+      auto &sa = segments[a.seg];
+      auto &sb = segments[b.seg];
+      if (sa.wire == sb.wire) {
+        continue;
+      }
+      long long lo = b.lo;
+      long long hi = min(a.hi, b.hi);
+      for (long long p : {lo, hi, clamp(0LL, lo, hi), clamp(-1LL, lo, hi),
+                           clamp(1LL, lo, hi)}) {
+        if (a.horizontal) {
+          out.add(p, a.line, sa, sb);
+        } else {
+          out.add(a.line, p, sa, sb);
+        }
+      }
+    }
+  }
+}
 
 int main() {
-  grid.drawFromInput(POSITIVE);
-  grid.drawFromInput(NEGATIVE);
+  vector<Segment> segments;
+  readWire(0, segments);
+  readWire(1, segments);
 
-  int dist = 0;
-  int min_total_steps = numeric_limits<int>::max();
+  Crossings crossings;
+  perpendicularCrossings(segments, crossings);
+  collinearCrossings(segments, crossings);
 
-  for (auto cross : grid._crosses) {
-    if (cross.x == 0 && cross.y == 0) {
-      continue;
-    }
-    int total_steps =
-        grid._total_steps_negative[cross] + grid._total_steps_positive[cross];
-    if (total_steps < min_total_steps) {
-      min_total_steps = total_steps;
-      dist = abs(cross.x) + abs(cross.y);
-    }
-  }
-  printf("dist: %d\n", dist);
-  printf("min_total_steps: %d\n", min_total_steps);
+  printf("min_dist: %lld\n", crossings.min_dist);
+  printf("min_total_steps: %lld\n", crossings.min_total_steps);
 
   return 0;
 }
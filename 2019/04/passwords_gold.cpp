@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
@@ -27,6 +28,103 @@ bool is_valid(const char *s) {
   return has_duplicate;
 }
 
+// Digit DP over non-decreasing digit strings of a fixed width (leading zeros
+// count as digits, like the %06d formatting above).
+//
+// State after a prefix: the last digit, the length of the run of that digit
+// (capped at 3, 0 before the first digit) and whether an earlier run had
+// exactly two digits.
+#define MAX_WIDTH 20
+#define MAX_RUN 3
+
+struct PasswordCounter {
+  PasswordCounter() { memset(_memo, -1, sizeof(_memo)); }
+
+  // Number of ways to fill the remaining `left` digits into a valid password.
+  long long completions(int left, int last, int run, bool has_pair) {
+    if (left == 0) {
+      return (has_pair || run == 2) ? 1 : 0;
+    }
+    long long &memo = _memo[left][last][run][has_pair];
+    if (memo >= 0) {
+      return memo;
+    }
+    memo = 0;
+    for (int d = last; d <= 9; d++) {
+      memo += completions(left - 1, d, nextRun(run, last, d),
+                          nextHasPair(has_pair, run, last, d));
+    }
+    return memo;
+  }
+
+  // Number of valid passwords that are `width` digits long and at most the
+  // `width`-digit string s, or below it if !inclusive. Works on the digits
+  // directly, so s can be past the range of any integer type.
+  long long countUpTo(const char *s, int width, bool inclusive = true) {
+    assert((int)strlen(s) == width);
+
+    long long count = 0;
+    int last = 0;
+    int run = 0;
+    bool has_pair = false;
+    for (int pos = 0; pos < width; pos++) {
+      const int limit = s[pos] - '0';
+      // all digits below the limit free the rest of the string
+      for (int d = last; d < limit; d++) {
+        count += completions(width - pos - 1, d, nextRun(run, last, d),
+                             nextHasPair(has_pair, run, last, d));
+      }
+      if (limit < last) {
+        return count;  // s itself (and anything above) is decreasing
+      }
+      has_pair = nextHasPair(has_pair, run, last, limit);
+      run = nextRun(run, last, limit);
+      last = limit;
+    }
+    return count + ((inclusive && (has_pair || run == 2)) ? 1 : 0);
+  }
+
+  // Number of valid `width`-digit passwords in [a, b], given as `width`-digit
+  // strings.
+  long long countInRange(const char *a, const char *b, int width) {
+    if (strcmp(a, b) > 0) {
+      return 0;
+    }
+    return countUpTo(b, width) - countUpTo(a, width, false);
+  }
+
+  long long countInRange(int a, int b, int width) {
+    char as[MAX_WIDTH + 1];
+    char bs[MAX_WIDTH + 1];
+    snprintf(as, sizeof(as), "%0*d", width, a);
+    snprintf(bs, sizeof(bs), "%0*d", width, b);
+    return countInRange(as, bs, width);
+  }
+
+ private:
+  static int nextRun(int run, int last, int d) {
+    return (run > 0 && d == last) ? std::min(run + 1, MAX_RUN) : 1;
+  }
+
+  static bool nextHasPair(bool has_pair, int run, int last, int d) {
+    return has_pair || (d != last && run == 2);
+  }
+
+  long long _memo[MAX_WIDTH + 1][10][MAX_RUN + 1][2];
+};
+
+int countByBruteForce(int a, int b) {
+  char is[10];
+  int count = 0;
+  for (int i = a; i <= b; i++) {
+    sprintf(is, "%06d", i);
+    if (is_valid(is)) {
+      count += 1;
+    }
+  }
+  return count;
+}
+
 int main() {
   // my tests
   assert(is_valid("136778"));
@@ -38,26 +136,41 @@ int main() {
   assert(!is_valid("123444"));
   assert(is_valid("111122"));
 
-  char as[10];
-  char bs[10];
+  PasswordCounter counter;
+
+  // digit DP agrees with is_valid() on small ranges
+  srand(2019);
+  for (int t = 0; t < 100; t++) {
+    int a = rand() % 1000000;
+    int b = std::min(a + rand() % 5000, 999999);
+    assert(counter.countInRange(a, b, 6) == countByBruteForce(a, b));
+  }
 
-  scanf("%6s-%6s\n", as, bs);
-  int a = atoi(as);
-  int b = atoi(bs);
+  char as[MAX_WIDTH + 1];
+  char bs[MAX_WIDTH + 1];
+  if (scanf("%20[0-9]-%20[0-9]", as, bs) != 2) {
+    fprintf(stderr, "expected a range like 123456-654321\n");
+    return 1;
+  }
 
-  printf("%06d-%06d\n", a, b);
+  // a gets the leading zeros to be as wide as b
+  const int width = (int)strlen(bs);
+  char a[MAX_WIDTH + 1];
+  if ((int)strlen(as) > width) {
+    fprintf(stderr, "%s is wider than %s\n", as, bs);
+    return 1;
+  }
+  const int pad = width - (int)strlen(as);
+  memset(a, '0', pad);
+  strcpy(a + pad, as);
 
-  char is[10];
-  int count = 0;
-  for (int i = a; i <= b; i++) {
-    sprintf(is, "%06d", i);
-    printf("%s\n", is);
-    bool valid = is_valid(is);
-    if (valid) {
-      count += 1;
-    }
+  printf("%s-%s\n", a, bs);
+
+  long long count = counter.countInRange(a, bs, width);
+  if (width == 6) {
+    assert(count == countByBruteForce(atoi(a), atoi(bs)));
   }
-  printf("%d\n", count);
+  printf("%lld\n", count);
 
   return 0;
 }
@@ -1,58 +1,179 @@
+#include <cassert>
 #include <cstdio>
 #include <cstring>
-#include <limits>
-#include <queue>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "lib.h"
 
 using namespace std;
 
-unordered_map<string, string> parent;
+// Orbit tree over dense integer ids. Names are only hashed while parsing;
+// depths come from a single pass in topological order and transfer
+// distances from binary-lifting LCA queries.
+struct OrbitGraph {
+  int intern(const string &name) {
+    if (int *id = lookup(_ids, name)) {
+      return *id;
+    }
+    int id = (int)_parent.size();
+    _ids.emplace(name, id);
+    _parent.push_back(-1);
+    return id;
+  }
 
-int count(const string &k) {
-  if (const auto *p = lookup(parent, k)) {
-    return 1 + count(*p);
+  int id(const string &name) {
+    int *id = lookup(_ids, name);
+    return id ? *id : -1;
   }
-  return 0;
-}
 
-int dist_to_dest(const string &from, string dest) {
-  string *par = &dest;
-  for (int par_dist = 0; par; par = lookup(parent, *par), par_dist++) {
-    if (*par == from) {
-      return par_dist;
+  void addOrbit(const string &center, const string &body) {
+    int c = intern(center);
+    int b = intern(body);
+    assert(_parent[b] == -1 && "a body orbits a single center");
+    _parent[b] = c;
+  }
+
+  int size() const { return (int)_parent.size(); }
+
+  // Computes depth[] and the ancestor tables. Must be called after all
+  // orbits are added.
+  void build() {
+    const int n = size();
+
+    // children in CSR form
+    vector<int> first_child(n + 1, 0);
+    for (int v = 0; v < n; v++) {
+      if (_parent[v] >= 0) {
+        first_child[_parent[v] + 1] += 1;
+      }
+    }
+    for (int v = 0; v < n; v++) {
+      first_child[v + 1] += first_child[v];
+    }
+    vector<int> children(first_child[n]);
+    vector<int> next = first_child;
+    for (int v = 0; v < n; v++) {
+      if (_parent[v] >= 0) {
+        children[next[_parent[v]]++] = v;
+      }
+    }
+
+    // topological order (BFS from the roots), parents before children
+    _depth.assign(n, 0);
+    vector<int> order;
+    order.reserve(n);
+    for (int v = 0; v < n; v++) {
+      if (_parent[v] < 0) {
+        order.push_back(v);
+      }
+    }
+    for (size_t i = 0; i < order.size(); i++) {
+      int v = order[i];
+      for (int c = first_child[v]; c < first_child[v + 1]; c++) {
+        _depth[children[c]] = _depth[v] + 1;
+        order.push_back(children[c]);
+      }
+    }
+    assert((int)order.size() == n && "orbits must form a forest");
+
+    // _up[k][v] is the 2^k-th ancestor of v (or the root)
+    int max_depth = 0;
+    for (int d : _depth) {
+      max_depth = max(max_depth, d);
+    }
+    int levels = 1;
+    while ((1 << levels) <= max_depth) {
+      levels += 1;
+    }
+    _up.assign(levels, vector<int>(n));
+    for (int v = 0; v < n; v++) {
+      _up[0][v] = _parent[v] >= 0 ? _parent[v] : v;
+    }
+    for (int k = 1; k < levels; k++) {
+      for (int v : order) {
+        _up[k][v] = _up[k - 1][_up[k - 1][v]];
+      }
     }
   }
-  return -1;
-}
 
-int main() {
-  char a[5];
-  char b[5];
-  while (scanf("%3s)%3s\n", a, b) == 2) {
-    parent[b] = a;
+  // Number of direct and indirect orbits.
+  long long totalOrbits() const {
+    long long total = 0;
+    for (int d : _depth) {
+      total += d;
+    }
+    return total;
   }
 
-  int count_sum = 0;
-  for (const auto &p : parent) {
-    count_sum += count(p.first);
+  int ancestor(int v, int dist) const {
+    for (int k = 0; dist > 0; k++, dist >>= 1) {
+      if (dist & 1) {
+        v = _up[k][v];
+      }
+    }
+    return v;
   }
-  printf("count: %d\n", count_sum);
 
-  // minimum num of transfers (part 2)
-  int min_dist = numeric_limits<int>::max();
-  int par_dist = 1;
-  for (auto *par = lookup(parent, "YOU"); par; par = lookup(parent, *par)) {
-    int dist = dist_to_dest(*par, "SAN");
-    if (dist >= 0) {
-      dist += par_dist;
-      min_dist = min(min_dist, dist);
+  int lca(int a, int b) const {
+    if (_depth[a] < _depth[b]) {
+      swap(a, b);
+    }
+    a = ancestor(a, _depth[a] - _depth[b]);
+    if (a == b) {
+      return a;
+    }
+    for (int k = (int)_up.size() - 1; k >= 0; k--) {
+      if (_up[k][a] != _up[k][b]) {
+        a = _up[k][a];
+        b = _up[k][b];
+      }
     }
-    par_dist++;
+    return _parent[a];
+  }
+
+  // Number of edges between a and b, or -1 if they are in different trees.
+  int dist(int a, int b) const {
+    int c = lca(a, b);
+    if (c < 0) {
+      return -1;
+    }
+    return _depth[a] + _depth[b] - 2 * _depth[c];
+  }
+
+  // Minimum number of orbital transfers to move from the object `from`
+  // orbits to the object `to` orbits.
+  int transfers(int from, int to) const {
+    int d = dist(from, to);
+    return d < 0 ? -1 : d - 2;
+  }
+
+ private:
+  unordered_map<string, int> _ids;
+  vector<int> _parent;
+  vector<int> _depth;
+  vector<vector<int>> _up;
+};
+
+OrbitGraph orbits;
+
+int main() {
+  char a[64];
+  char b[64];
+  while (scanf("%63[^)])%63s\n", a, b) == 2) {
+    orbits.addOrbit(a, b);
+  }
+  orbits.build();
+
+  printf("count: %lld\n", orbits.totalOrbits());
+
+  // minimum num of transfers (part 2)
+  int you = orbits.id("YOU");
+  int san = orbits.id("SAN");
+  if (you >= 0 && san >= 0) {
+    printf("min_transfers: %d\n", orbits.transfers(you, san));
   }
-  printf("min_transfers: %d\n", min_dist - 2);
 
   return 0;
 }
@@ -1,43 +1,138 @@
+#include <cassert>
+#include <cctype>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
 
-#define W 25
-#define H 6
-#define LEN (W * H)
+#include "lib.h"
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define HAVE_AVX2_KERNEL 1
+#endif
+
+// Usage: ./a.out [width height] < in
+#define DEFAULT_W 25
+#define DEFAULT_H 6
+
+struct LayerHistogram {
+  int count[3] = {0, 0, 0};  // of '0', '1' and '2'
+};
+
+// Decodes a Space Image Format stream layer by layer. Pixels are kept as the
+// ASCII digits of the input, so compositing is a byte blend: every pixel
+// that is still transparent ('2') takes the value of the next layer.
 struct Image {
-  Image() {
-    for (int i = 0; i < LEN; i++) {
-      pixbuf[i] = 2;
+  Image(int width, int height)
+      : width(width), height(height), pixels(width * height, '2') {}
+
+  void addLayer(const char *layer) {
+    LayerHistogram hist;
+    int i = 0;
+#ifdef HAVE_AVX2_KERNEL
+    if (__builtin_cpu_supports("avx2")) {
+      i = blendAVX2(layer, &hist);
     }
+#endif
+    blendScalar(layer, i, &hist);
+    layer_hists.push_back(hist);
   }
 
-  int pixbuf[LEN];
-};
+  // Blends pixels [from, width * height) of the layer.
+  void blendScalar(const char *layer, int from, LayerHistogram *hist) {
+    const int len = width * height;
+    for (int i = from; i < len; i++) {
+      hist->count[layer[i] - '0'] += 1;
+      if (pixels[i] == '2') {
+        pixels[i] = layer[i];
+      }
+    }
+  }
 
-int main() {
-  Image image;
-  for (int i = 0;; i = (i + 1) % LEN) {
-    char c = getchar();
-    if (c == EOF || c == '\n') {
-      break;
+#ifdef HAVE_AVX2_KERNEL
+  // 32 pixels per step: blend the layer into the still-transparent pixels
+  // and count its digits with compare + movemask + popcount. Returns how
+  // many pixels were blended.
+  __attribute__((target("avx2,popcnt"))) int blendAVX2(const char *layer,
+                                                       LayerHistogram *hist) {
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i one = _mm256_set1_epi8('1');
+    const __m256i two = _mm256_set1_epi8('2');
+    const int len = width * height;
+    char *out = pixels.data();
+
+    int i = 0;
+    for (; i + 32 <= len; i += 32) {
+      __m256i src = _mm256_loadu_si256((const __m256i *)(layer + i));
+      __m256i cur = _mm256_loadu_si256((const __m256i *)(out + i));
+      __m256i transparent = _mm256_cmpeq_epi8(cur, two);
+      cur = _mm256_blendv_epi8(cur, src, transparent);
+      _mm256_storeu_si256((__m256i *)(out + i), cur);
+
+      hist->count[0] += __builtin_popcount(
+          (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(src, zero)));
+      hist->count[1] += __builtin_popcount(
+          (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(src, one)));
+      hist->count[2] += __builtin_popcount(
+          (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(src, two)));
     }
-    auto &pixel = image.pixbuf[i];
-    if (pixel == 2) {
-      pixel = c - '0';
+    return i;
+  }
+#endif
+
+  // Checksum of the layer with the fewest '0' digits (part 1).
+  long long checksum() const {
+    const LayerHistogram *min_zeroes = nullptr;
+    for (auto &hist : layer_hists) {
+      if (!min_zeroes || hist.count[0] < min_zeroes->count[0]) {
+        min_zeroes = &hist;
+      }
     }
+    assert(min_zeroes);
+    return (long long)min_zeroes->count[1] * min_zeroes->count[2];
   }
 
-  for (int i = 0; i < H; i++) {
-    for (int j = 0; j < W; j++) {
-      int p = image.pixbuf[i * W + j];
-      if (p == 0) {
-        putchar(' ');
-      } else {
-        putchar('#');
+  void render() const {
+    for (int i = 0; i < height; i++) {
+      for (int j = 0; j < width; j++) {
+        putchar(pixels[i * width + j] == '1' ? '#' : ' ');
       }
+      putchar('\n');
     }
-    putchar('\n');
   }
 
+  const int width;
+  const int height;
+  std::vector<char> pixels;
+  std::vector<LayerHistogram> layer_hists;
+};
+
+int main(int argc, char *argv[]) {
+  int width = DEFAULT_W;
+  int height = DEFAULT_H;
+  if (argc == 3) {
+    width = atoi(argv[1]);
+    height = atoi(argv[2]);
+  }
+  assert(width > 0 && height > 0);
+
+  Input input;
+  size_t len = input.size();
+  while (len > 0 && isspace(input.data()[len - 1])) {
+    len--;
+  }
+  const size_t layer_len = (size_t)width * height;
+  assert(len % layer_len == 0 && "input is not a whole number of layers");
+
+  Image image(width, height);
+  for (size_t offset = 0; offset < len; offset += layer_len) {
+    image.addLayer(input.data() + offset);
+  }
+
+  printf("layers: %zu\n", image.layer_hists.size());
+  printf("count_1 * count_2 = %lld\n", image.checksum());
+  image.render();
+
   return 0;
 }
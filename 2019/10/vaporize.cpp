@@ -1,14 +1,8 @@
-// BROKEN SOLUTION
-
 #include <algorithm>
 #include <cassert>
-#include <cmath>
 #include <cstdio>
 #include <cstdlib>
-#include <cstring>
-#include <unordered_set>
 #include <string>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -16,25 +10,19 @@
 
 using namespace std;
 
-#define MAXN 1000
-char _map[MAXN][MAXN];
-int height = 0;
-int width = 0;
+vector<string> _map;
 
 void render() {
-  for (int y = 0; y < height; y++) {
-    for (int x = 0; x < width; x++) {
-      putchar(_map[y][x]);
-    }
-    putchar('\n');
+  for (auto &row : _map) {
+    puts(row.c_str());
   }
   putchar('\n');
 }
 
 vector<Vec> asteroidsFromMap() {
   vector<Vec> asteroids;
-  for (int y = 0; y < height; y++) {
-    for (int x = 0; x < width; x++) {
+  for (int y = 0; y < (int)_map.size(); y++) {
+    for (int x = 0; x < (int)_map[y].size(); x++) {
       char c = _map[y][x];
       if (c == '#' || isalpha(c)) {
         asteroids.emplace_back(x, y);
@@ -44,118 +32,179 @@ vector<Vec> asteroidsFromMap() {
   return asteroids;
 }
 
-double toAngle(Vec v) { return atan2(v.x, -v.y); }
-
-Vec findBestAsteroid(const vector<Vec> &asteroids, int &out_can_see) {
-  assert(asteroids.size() > 1);
-
-  out_can_see = 0;
+// Reduces v to the smallest integer vector with the same direction.
+// Two asteroids are on the same line of sight iff they reduce to the same
+// direction. out_steps gets how many such steps away v is.
+Vec direction(Vec v, int *out_steps) {
+  int g = (int)gcd(abs(v.x), abs(v.y));
+  *out_steps = g;
+  return Vec(v.x / g, v.y / g);
+}
 
-  Vec ret;
-  vector<Vec> sorted;
-  unordered_set<double> unique_angles;
-  for (auto &center : asteroids) {
-    sorted.clear();
-    unique_angles.clear();
+uint64_t directionKey(Vec d) {
+  return ((uint64_t)(uint32_t)d.x << 32) | (uint32_t)d.y;
+}
 
-    for (auto &a : asteroids) {
-      if (a != center) {
-        sorted.emplace_back(a - center);
-        unique_angles.insert(toAngle(a - center));
-      }
+// Flat (open-addressing) set of directions. Clearing is O(1): a slot only
+// counts as occupied if it was written in the current generation.
+struct DirectionSet {
+  explicit DirectionSet(size_t max_size) {
+    size_t cap = 16;
+    while (cap < max_size * 2) {
+      cap *= 2;
     }
+    _slots.resize(cap, Slot{0, 0});
+  }
 
-    // sort by (angle, distance^2) to center
-    sort(sorted.begin(), sorted.end(), [](const Vec &a, const Vec &b) {
-      Frac angle_a = toAngle(a);
-      Frac angle_b = toAngle(b);
-
-      if (angle_a < angle_b) {
+  void clear() { _generation += 1; }
+
+  // Returns true if d was not in the set yet.
+  bool insert(Vec d) {
+    const uint64_t key = directionKey(d);
+    const size_t mask = _slots.size() - 1;
+    uint64_t h = key * 0x9e3779b97f4a7c15ULL;
+    for (size_t i = (h >> 32) & mask;; i = (i + 1) & mask) {
+      Slot &slot = _slots[i];
+      if (slot.generation != _generation) {
+        slot.key = key;
+        slot.generation = _generation;
         return true;
       }
-      if (angle_a == angle_b) {
-        return a.lengthSquared() < b.lengthSquared();
+      if (slot.key == key) {
+        return false;
       }
-      return false;
-    });
-
-    // calculate how many can be seen from center
-    double cur = toAngle(sorted[0]);
-    int can_see = 1;
-    for (int i = 1; i < sorted.size(); i++) {
-      double angle = toAngle(sorted[i]);
-      if (cur == angle)
+    }
+  }
+
+ private:
+  struct Slot {
+    uint64_t key;
+    uint32_t generation;
+  };
+
+  std::vector<Slot> _slots;
+  uint32_t _generation = 1;
+};
+
+// How many asteroids can be seen from each center in [begin, end). O(n) per
+// center: one direction per other asteroid, seen ones are the unique ones.
+void countVisible(const vector<Vec> &asteroids, int begin, int end,
+                  vector<int> &out_can_see) {
+  DirectionSet directions(asteroids.size());
+  for (int i = begin; i < end; i++) {
+    const Vec center = asteroids[i];
+    directions.clear();
+    int can_see = 0;
+    for (auto &a : asteroids) {
+      if (a == center) {
         continue;
-      cur = angle;
-      can_see += 1;
+      }
+      int steps;
+      if (directions.insert(direction(a - center, &steps))) {
+        can_see += 1;
+      }
     }
+    out_can_see[i] = can_see;
+  }
+}
 
-    if (can_see > out_can_see) {
-      out_can_see = can_see;
-      ret = center;
+Vec findBestAsteroid(const vector<Vec> &asteroids, int &out_can_see) {
+  assert(asteroids.size() > 1);
+  const int n = (int)asteroids.size();
+
+  vector<int> can_see(n, 0);
+  parallel_for_chunks(0, n, [&](int begin, int end) {
+    countVisible(asteroids, begin, end, can_see);
+  });
+
+  int best = 0;
+  for (int i = 1; i < n; i++) {
+    if (can_see[i] > can_see[best]) {
+      best = i;
     }
-    /* if (unique_angles.size() > out_can_see) { */
-    /*   out_can_see = unique_angles.size(); */
-    /*   ret = center; */
-    /* } */
   }
+  out_can_see = can_see[best];
+  return asteroids[best];
+}
 
-  return ret;
+// Clockwise order starting from "up" (y grows downwards), with exact
+// integer arithmetic: first the half-plane, then the cross product.
+bool clockwiseBefore(Vec a, Vec b) {
+  auto half = [](Vec v) { return (v.x > 0 || (v.x == 0 && v.y < 0)) ? 0 : 1; };
+  int ha = half(a);
+  int hb = half(b);
+  if (ha != hb) {
+    return ha < hb;
+  }
+  return (long long)a.x * b.y - (long long)a.y * b.x > 0;
 }
 
-/* bool canSee(const vector<Vec> &asteroids, Vec from, Vec target) { */
-/*   Line line(from, target); */
-
-/*   int min_x = min(from.x, target.x); */
-/*   int min_y = min(from.y, target.y); */
-/*   int max_x = max(from.x, target.x); */
-/*   int max_y = max(from.y, target.y); */
-
-/*   bool blocked = false; */
-/*   Vec _min = Vec(min_x, min_y); */
-/*   Vec _max = Vec(max_x, max_y); */
-/*   for (auto blocker : asteroids) { */
-/*     if (blocker > _max || blocker < _min) { */
-/*       continue; */
-/*     } */
-/*     if (blocker == from || blocker == target) { */
-/*       continue; */
-/*     } */
-/*     if (line.contains(blocker)) { */
-/*       // dump(from, target, blocker); */
-/*       blocked = true; */
-
-/*       char letter_blocker = _map[blocker.y][blocker.x]; */
-/*       char &letter_target = _map[target.y][target.x]; */
-/*       if (letter_blocker != '#') { */
-/*         letter_target = tolower(letter_blocker); */
-/*       } */
-/*       break; */
-/*     } */
-/*   } */
-
-/*   return !blocked; */
-/* } */
+struct Target {
+  Vec pos;
+  Vec dir;
+  int steps;  // distance along dir
+  int round;  // rotation of the laser in which it gets vaporized
+};
+
+// The order in which the laser at `center` vaporizes all other asteroids.
+// Targets are sorted by angle once and bucketed by how many asteroids are in
+// front of them on the same line of sight, which is the round in which the
+// laser reaches them.
+vector<Vec> vaporizationOrder(const vector<Vec> &asteroids, Vec center) {
+  vector<Target> targets;
+  targets.reserve(asteroids.size());
+  for (auto &a : asteroids) {
+    if (a != center) {
+      Target t;
+      t.pos = a;
+      t.dir = direction(a - center, &t.steps);
+      targets.push_back(t);
+    }
+  }
+
+  sort(targets.begin(), targets.end(), [](const Target &a, const Target &b) {
+    if (a.dir != b.dir) {
+      return clockwiseBefore(a.dir, b.dir);
+    }
+    return a.steps < b.steps;
+  });
+
+  vector<vector<Vec>> rounds;
+  for (size_t i = 0; i < targets.size(); i++) {
+    auto &t = targets[i];
+    t.round = (i > 0 && targets[i - 1].dir == t.dir) ? targets[i - 1].round + 1
+                                                      : 0;
+    if (t.round >= (int)rounds.size()) {
+      rounds.resize(t.round + 1);
+    }
+    rounds[t.round].push_back(t.pos);  // already in angle order
+  }
+
+  vector<Vec> order;
+  order.reserve(targets.size());
+  for (auto &round : rounds) {
+    order.insert(order.end(), round.begin(), round.end());
+  }
+  return order;
+}
 
 int main() {
-  int y = 0;
-  int x = 0;
+  string row;
   for (;;) {
-    char c = getchar();
-    if (c == EOF) {
-      break;
-    }
-    if (c == '.' || c == '#' || isalpha(c)) {
-      _map[y][x] = c;
-      x += 1;
-    } else if (c == '\n') {
-      y += 1;
-      assert(width == x || width == 0);
-      width = x;
-      x = 0;
+    int c = getchar();
+    if (c == EOF || c == '\n') {
+      if (!row.empty()) {
+        assert(_map.empty() || _map[0].size() == row.size());
+        _map.push_back(std::move(row));
+        row.clear();
+      }
+      if (c == EOF) {
+        break;
+      }
+    } else if (c == '.' || c == '#' || isalpha(c)) {
+      row += (char)c;
     }
   }
-  height = y;
 
   render();
 
@@ -168,9 +217,11 @@ int main() {
          can_see);
   _map[best_asteroid.y][best_asteroid.x] = 'X';
 
-  // Vec center(11, 19); // for answer
-  // Vec center(11, 13); // for big map
-  // Vec center(8, 3);
+  auto order = vaporizationOrder(all_asteroids, best_asteroid);
+  if (order.size() >= 200) {
+    Vec v = order[199];
+    printf("200th vaporized asteroid %d,%d: %d\n", v.x, v.y, v.x * 100 + v.y);
+  }
 
   return 0;
 }
@@ -5,54 +5,125 @@
 #include <cstring>
 
 #include "intcode.h"
+#include "lib.h"
+
+#define TILE_BITS 6
+#define TILE_SIZE (1 << TILE_BITS)  // 64x64 cells, one uint64_t per row
+
+// Unbounded canvas made of bit-packed tiles. Tiles are stored contiguously
+// and found through a flat hash keyed by tile coordinate; the robot moves one
+// cell at a time, so the last tile used is cached and most accesses skip
+// the hash entirely. Cells painted at least once are tracked in a separate
+// bit plane.
+struct Canvas {
+  struct Tile {
+    Vec origin;  // tile coordinate
+    uint64_t white[TILE_SIZE] = {};
+    uint64_t painted[TILE_SIZE] = {};
+  };
+
+  // Cells of tiles never painted are black; reading them adds no tile.
+  bool isWhite(Vec pos) const {
+    const Tile *tile = findTile(pos);
+    return tile &&
+           ((tile->white[pos.y & (TILE_SIZE - 1)] >> (pos.x & (TILE_SIZE - 1))) &
+            1);
+  }
 
-#define MAXN 1000
-char grid[MAXN][MAXN];
-
-#define BACKGROUND '\0'
-#define BLACK '.'
-#define WHITE '#'
-
-char turnLeft(char dir) {
-  switch (dir) {
-    case '^':
-      return '<';
-    case '>':
-      return '^';
-    case 'v':
-      return '>';
-    case '<':
-      return 'v';
+  // Returns true if the cell had never been painted.
+  bool paint(Vec pos, bool white) {
+    Tile &tile = tileAt(pos);
+    const uint64_t bit = 1ULL << (pos.x & (TILE_SIZE - 1));
+    const int row = pos.y & (TILE_SIZE - 1);
+    if (white) {
+      tile.white[row] |= bit;
+    } else {
+      tile.white[row] &= ~bit;
+    }
+    const bool first_time = (tile.painted[row] & bit) == 0;
+    tile.painted[row] |= bit;
+    return first_time;
   }
-  return dir;
-}
 
-char turnRight(char dir) {
-  switch (dir) {
-    case '^':
-      return '>';
-    case '>':
-      return 'v';
-    case 'v':
-      return '<';
-    case '<':
-      return '^';
+  int countPainted() const {
+    int count = 0;
+    for (auto &tile : _tiles) {
+      for (auto row : tile.painted) {
+        count += __builtin_popcountll(row);
+      }
+    }
+    return count;
   }
-  return dir;
-}
 
-struct Robot {
-  explicit Robot(Program program) : cpu(std::move(program)) {}
+  // Bounding box of the white cells; false if there are none.
+  bool whiteBounds(Vec *out_min, Vec *out_max) const {
+    bool found = false;
+    for (auto &tile : _tiles) {
+      for (int row = 0; row < TILE_SIZE; row++) {
+        for (int col = 0; col < TILE_SIZE; col++) {
+          if ((tile.white[row] >> col) & 1) {
+            Vec p(tile.origin.x * TILE_SIZE + col,
+                  tile.origin.y * TILE_SIZE + row);
+            if (!found) {
+              *out_min = *out_max = p;
+              found = true;
+            }
+            *out_min = Vec(std::min(out_min->x, p.x), std::min(out_min->y, p.y));
+            *out_max = Vec(std::max(out_max->x, p.x), std::max(out_max->y, p.y));
+          }
+        }
+      }
+    }
+    return found;
+  }
+
+  size_t numTiles() const { return _tiles.size(); }
+
+ private:
+  static Vec tileOrigin(Vec pos) {
+    return Vec(pos.x >> TILE_BITS, pos.y >> TILE_BITS);
+  }
 
-  int currentColorToInput() {
-    char c = currentColor();
-    if (c == BLACK || c == BACKGROUND) {
-      return 0;
+  const Tile *findTile(Vec pos) const {
+    Vec origin = tileOrigin(pos);
+    if (_cached >= 0 && _tiles[_cached].origin == origin) {
+      return &_tiles[_cached];
     }
-    assert(c == WHITE);
-    return 1;
+    auto it = _index.find(origin);
+    return it != _index.end() ? &_tiles[it->second] : nullptr;
   }
 
+  Tile &tileAt(Vec pos) {
+    Vec origin = tileOrigin(pos);
+    if (_cached >= 0 && _tiles[_cached].origin == origin) {
+      return _tiles[_cached];
+    }
+    auto [it, inserted] = _index.emplace(origin, (int)_tiles.size());
+    if (inserted) {
+      _tiles.emplace_back();
+      _tiles.back().origin = origin;
+    }
+    _cached = it->second;
+    return _tiles[_cached];
+  }
+
+  std::vector<Tile> _tiles;
+  FlatMap<Vec, int> _index;
+  int _cached = -1;
+};
+
+#define UP Vec(0, -1)
+
+// Quarter turns, with y growing downwards: counter-clockwise on screen...
+Vec turnLeft(Vec dir) { return Vec(dir.y, -dir.x); }
+// ... and clockwise.
+Vec turnRight(Vec dir) { return Vec(-dir.y, dir.x); }
+
+struct Robot {
+  explicit Robot(Program program) : cpu(std::move(program)) {}
+
+  int currentColorToInput() { return canvas.isWhite(pos) ? 1 : 0; }
+
   int run(bool first_white) {
     while (cpu.status != HALTED) {
       cpu.pushInput(first_white ? 1 : currentColorToInput());
@@ -64,11 +135,9 @@ struct Robot {
         break;
       }
       auto paint_command = cpu.consumeOutput();
-      if (paint_command == 0) {
-        paint(BLACK);
-      } else {
-        assert(paint_command == 1);
-        paint(WHITE);
+      assert(paint_command == 0 || paint_command == 1);
+      if (canvas.paint(pos, paint_command == 1)) {
+        paint_area += 1;
       }
 
       // Run and get turn command output
@@ -89,72 +158,30 @@ struct Robot {
     return paint_area;
   }
 
-  void move() {
-    switch (direction) {
-      case '^':
-        pos_i -= 1;
-        break;
-      case '>':
-        pos_j += 1;
-        break;
-      case 'v':
-        pos_i += 1;
-        break;
-      case '<':
-        pos_j -= 1;
-        break;
-    }
-    min_i = std::min(min_i, pos_i);
-    min_j = std::min(min_j, pos_j);
-    max_i = std::max(max_i, pos_i);
-    max_j = std::max(max_j, pos_j);
-  }
-
-  char &currentColor() {
-    assert(pos_i >= 0);
-    assert(pos_i < MAXN);
-    assert(pos_j >= 0);
-    assert(pos_j < MAXN);
-    return grid[pos_i][pos_j];
-  }
+  void move() { pos += direction; }
 
-  void paint(char color) {
-    if (currentColor() == BACKGROUND) {
-      paint_area += 1;
-    }
-    currentColor() = color;
-  }
-
-  void display() {
+  void display() const {
     putchar('\n');
-    for (int i = min_i; i <= max_i; i++) {
-      for (int j = min_j; j <= max_j; j++) {
-        char color = grid[i][j];
-        if (color == BLACK || color == BACKGROUND) {
-          putchar(' ');
-        } else if (color == WHITE) {
-          putchar('#');
+    Vec min, max;
+    if (canvas.whiteBounds(&min, &max)) {
+      for (int y = min.y; y <= max.y; y++) {
+        for (int x = min.x; x <= max.x; x++) {
+          putchar(canvas.isWhite(Vec(x, y)) ? '#' : ' ');
         }
+        putchar('\n');
       }
-      putchar('\n');
     }
     putchar('\n');
   }
 
   CPU cpu;
-  int pos_i = 100;
-  int pos_j = 100;
-  int min_i = pos_i;
-  int min_j = pos_j;
-  int max_i = pos_i;
-  int max_j = pos_j;
+  Canvas canvas;
+  Vec pos;
+  Vec direction = UP;
   int paint_area = 0;
-  char direction = '^';
 };
 
 int main() {
-  memset(grid, BACKGROUND, sizeof(grid));
-
   Program program;
   Word opcode;
   while (scanf("%lld", &opcode)) {
@@ -172,6 +199,7 @@ int main() {
   int paint_area = robot.run(first_white);
   robot.display();
   printf("Painted %d area\n", paint_area);
+  assert(paint_area == robot.canvas.countPainted());
 
   return 0;
 }
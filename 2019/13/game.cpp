@@ -1,8 +1,11 @@
-#include <unistd.h>
+#include <chrono>
 #include <cstdio>
+#include <cstring>
+#include <utility>
 #include <vector>
 
 #include "intcode.h"
+#include "terminal.h"
 
 #define MAXN 100
 
@@ -49,57 +52,70 @@ struct Vec {
 struct State {
   State() { memset(map, 0, sizeof(map)); }
 
-  int &cell(int x, int y) {
+  int cell(int x, int y) const {
+    assert(x >= 0 && x < MAXN && y >= 0 && y < MAXN);
+    return map[y][x];
+  }
+
+  void set(int x, int y, int kind) {
     assert(x >= 0);
     assert(y >= 0);
     assert(x < MAXN);
     assert(y < MAXN);
     int &cell = map[y][x];
+    if (journaling) {
+      _journal.emplace_back(&cell, cell);
+    }
+    cell = kind;
     min_x = std::min(min_x, x);
     min_y = std::min(min_y, y);
     max_x = std::max(max_x, x);
     max_y = std::max(max_y, y);
-    return cell;
   }
 
-  void render() const {
-    // printf("\x1B[0;0H");
+  size_t journalSize() const { return _journal.size(); }
+
+  void rollback(size_t journal_size) {
+    while (_journal.size() > journal_size) {
+      auto [cell, old_kind] = _journal.back();
+      *cell = old_kind;
+      _journal.pop_back();
+    }
+  }
+
+  void render(Terminal &term) const {
     for (int y = min_y; y <= max_y; y++) {
       for (int x = min_x; x <= max_x; x++) {
-        switch (map[y][x]) {
-          case 0:
-            putchar(' ');
-            break;
-          case WALL:
-            putchar('|');
-            break;
-          case BLOCK:
-            putchar('#');
-            break;
-          case PADDLE:
-            putchar('-');
-            break;
-          case BALL:
-            putchar('O');
-            break;
-        }
+        term.put(x - min_x, y - min_y, tileToAscii(map[y][x]));
       }
-      putchar('\n');
     }
-    putchar('\n');
   }
 
-  void endFrame() const {
-    int ms = 12;
-    usleep(ms * 1000);
+  int height() const { return max_y - min_y + 1; }
+
+  static char tileToAscii(int kind) {
+    switch (kind) {
+      case WALL:
+        return '|';
+      case BLOCK:
+        return '#';
+      case PADDLE:
+        return '-';
+      case BALL:
+        return 'O';
+    }
+    return ' ';
   }
 
+  bool journaling = false;
+
  private:
   int map[MAXN][MAXN];
   int min_x = 0;
   int min_y = 0;
   int max_x = 0;
   int max_y = 0;
+  std::vector<std::pair<int *, int>> _journal;  // (cell, old kind)
 };
 
 struct Game {
@@ -135,9 +151,10 @@ struct Game {
         continue;
       }
 
-      int &cell = state.cell(x, y);
-
-      cell = kind;
+      if (state.cell(x, y) == BLOCK && kind != BLOCK) {
+        blocks_broken += 1;
+      }
+      state.set(x, y, kind);
       if (kind == BALL) {
         auto new_ball_pos = Vec(x, y);
         ball_vel = new_ball_pos;
@@ -149,10 +166,12 @@ struct Game {
     }
   }
 
-  void render() const {
-    state.render();
-    printf("score %d\n", score);
-    state.endFrame();
+  void render(Terminal &term) const {
+    state.render(term);
+    char line[32];
+    snprintf(line, sizeof(line), "score %d", score);
+    term.print(0, state.height() + 1, line);
+    term.present();
   }
 
   bool ballMoving() const {
@@ -164,9 +183,39 @@ struct Game {
 
   bool over() const { return cpu.status == HALTED; }
 
+  int getScore() const { return score; }
+
+  struct Snapshot {
+    CPU::Checkpoint cpu;
+    size_t state_journal_size;
+    Vec ball_pos;
+    Vec ball_vel;
+    Vec paddle_pos;
+    int score;
+    int blocks_broken;
+  };
+
+  Snapshot snapshot() {
+    state.journaling = true;
+    return Snapshot{cpu.checkpoint(), state.journalSize(), ball_pos, ball_vel,
+                    paddle_pos,       score,               blocks_broken};
+  }
+
+  void rollback(const Snapshot &snap) {
+    cpu.rollback(snap.cpu);
+    state.rollback(snap.state_journal_size);
+    state.journaling = state.journalSize() > 0;
+    ball_pos = snap.ball_pos;
+    ball_vel = snap.ball_vel;
+    paddle_pos = snap.paddle_pos;
+    score = snap.score;
+    blocks_broken = snap.blocks_broken;
+  }
+
   Vec ball_pos;
   Vec ball_vel;
   Vec paddle_pos;
+  int blocks_broken = 0;
 
  private:
   State state;
@@ -174,7 +223,49 @@ struct Game {
   CPU cpu;
 };
 
-int main() {
+// Where the ball will land, found by running the game speculatively (with
+// the joystick in neutral) and rolling it back afterwards.
+struct Prediction {
+  int landing_x = 0;
+  int frames_left = 0;    // frames until the ball touches the paddle
+  int blocks_broken = 0;  // Game::blocks_broken when the ball lands
+};
+
+Prediction predictLanding(Game &game) {
+  auto snap = game.snapshot();
+  Prediction p;
+  for (; game.ballMoving(); p.frames_left++) {
+    game.pushInput(0);
+    game.update();
+  }
+  p.landing_x = game.ball_pos.x;
+  p.blocks_broken = game.blocks_broken;
+  p.frames_left += 1;  // for the iteration where the ball touches the paddle
+  game.rollback(snap);
+  return p;
+}
+
+// Usage: ./a.out [headless] [no-reuse] [fps=N] [skip-frames] < in
+//
+// The game is drawn at fps frames per second (60 by default). skip-frames
+// drops the frames that come too early instead of waiting for them.
+int main(int argc, char *argv[]) {
+  bool headless = false;
+  bool reuse_predictions = true;
+  int fps = 60;
+  bool skip_frames = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "headless") == 0) {
+      headless = true;
+    } else if (strcmp(argv[i], "no-reuse") == 0) {
+      reuse_predictions = false;
+    } else if (strncmp(argv[i], "fps=", 4) == 0) {
+      fps = atoi(argv[i] + 4);
+    } else if (strcmp(argv[i], "skip-frames") == 0) {
+      skip_frames = true;
+    }
+  }
+
   Program program;
   Word code;
   while (scanf("%lld", &code)) {
@@ -192,29 +283,45 @@ int main() {
   Game game(std::move(program));
   game.update();
 
-  int paddle_target_x = 0;
-  for (int known_future = 0; !game.over(); known_future--) {
-    if (known_future == 0) {
-      Game simulation(game);
-      for (; simulation.ballMoving(); known_future++) {
-        simulation.pushInput(0);
-        simulation.update();
-      }
-      paddle_target_x = simulation.ball_pos.x;
-
-      known_future += 1;  // for the iteration where the ball touches the paddle
+  Terminal terminal(fps, skip_frames);
+
+  auto start = std::chrono::steady_clock::now();
+  int frames = 0;
+  int predictions = 0;
+  Prediction prediction;
+  for (; !game.over(); prediction.frames_left--) {
+    // A prediction stays valid until the ball lands, unless the real game
+    // breaks a block the speculative run did not (trajectory changed).
+    if (!reuse_predictions || prediction.frames_left <= 0 ||
+        game.blocks_broken > prediction.blocks_broken) {
+      prediction = predictLanding(game);
+      predictions += 1;
     }
     int joystick = 0;
-    if (paddle_target_x > game.paddle_pos.x) {
+    if (prediction.landing_x > game.paddle_pos.x) {
       joystick = 1;
-    } else if (paddle_target_x < game.paddle_pos.x) {
+    } else if (prediction.landing_x < game.paddle_pos.x) {
       joystick = -1;
     }
 
     game.pushInput(joystick);
     game.update();
-    game.render();
+    frames += 1;
+    if (!headless) {
+      game.render(terminal);
+    }
   }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  if (!headless) {
+    terminal.present(true);  // last frame
+    terminal.printStats();
+  }
+
+  printf("score %d\n", game.getScore());
+  printf("%d frames, %d predictions in %.3fs (%.0f frames/s%s)\n", frames,
+         predictions, elapsed.count(), frames / elapsed.count(),
+         reuse_predictions ? "" : ", without prediction reuse");
 
   return 0;
 }
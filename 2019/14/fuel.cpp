@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdio>
+#include <cstring>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -36,100 +37,144 @@ struct Reaction {
   }
 };
 
+// The reactions compiled once into integer-indexed arrays, in topological
+// order: every chemical comes before all the chemicals used to make it, so
+// the ORE needed for any amount of FUEL is a single linear pass.
 struct Nanofactory {
-  explicit Nanofactory(Map<string, Reaction> reaction_for)
-      : _reaction_for(std::move(reaction_for)) {
-    for (auto &[result, _] : _reaction_for) {
-      _sorted_chemicals.push_back(result);
-    }
-
-    std::sort(_sorted_chemicals.begin(), _sorted_chemicals.end(),
-              [this](const string &a, const string &b) {
-                return distanceToOre(a) < distanceToOre(b);
-              });
-
-    for (auto &chemical : _sorted_chemicals) {
-      _ingredients_for[chemical] = gatherIngredientsFor(chemical);
+  explicit Nanofactory(const Map<string, Reaction> &reaction_for) {
+    _ore = idOf("ORE");
+    _fuel = idOf("FUEL");
+    for (auto &[result, r] : reaction_for) {
+      idOf(result);
+      for (auto &[chemical, _] : r.ingredients) {
+        idOf(chemical);
+      }
     }
-  }
-
-  Stock oreStock() { return _stock_of["ORE"]; }
-  void setOreStock(Stock stock) { _stock_of["ORE"] = stock; }
-  void restart() { _stock_of.clear(); }
-
-  void make(Stock to_make, const string &chemical) {
-    // printf("make(%lld, %s)\n", to_make, chemical.c_str());
-    auto &stock = _stock_of[chemical];
-
-    if (chemical == "ORE") {
-      stock -= to_make;
-      return;
+    const int n = (int)_names.size();
+
+    // Kahn's algorithm: a chemical is ready once all reactions consuming it
+    // are ordered
+    vector<int> consumers(n, 0);
+    for (auto &[result, r] : reaction_for) {
+      for (auto &[chemical, _] : r.ingredients) {
+        consumers[_ids[chemical]] += 1;
+      }
     }
-
-    if (stock > 0) {
-      auto take_from_stock = std::min(stock, to_make);
-      to_make -= take_from_stock;
-      stock -= take_from_stock;
+    vector<int> order;
+    for (int c = 0; c < n; c++) {
+      if (consumers[c] == 0) {
+        order.push_back(c);
+      }
     }
-    if (to_make == 0) {
-      return;
+    for (size_t i = 0; i < order.size(); i++) {
+      auto *r = lookup(reaction_for, _names[order[i]]);
+      if (!r) {
+        continue;  // ORE
+      }
+      for (auto &[chemical, _] : r->ingredients) {
+        if (--consumers[_ids[chemical]] == 0) {
+          order.push_back(_ids[chemical]);
+        }
+      }
     }
+    assert((int)order.size() == n && "reactions must not have cycles");
 
-    auto *r = lookup(_reaction_for, chemical);
-    const Stock repeat = (to_make - 1) / r->yield + 1;  // ceil(to_make / yield)
-    const auto &ingredients = *lookup(_ingredients_for, chemical);
-    for (auto &i : ingredients) {
-      make(repeat * *lookup(r->ingredients, i), i);
+    for (int c : order) {
+      auto *r = lookup(reaction_for, _names[c]);
+      if (!r) {
+        continue;
+      }
+      CompiledReaction compiled;
+      compiled.result = c;
+      compiled.yield = r->yield;
+      compiled.first_input = (int)_inputs.size();
+      for (auto &[chemical, quantity] : r->ingredients) {
+        _inputs.push_back(Input{_ids[chemical], quantity});
+      }
+      compiled.last_input = (int)_inputs.size();
+      _reactions.push_back(compiled);
     }
-    stock += repeat * r->yield - to_make;
-  }
 
- private:
-  Map<string, Reaction> _reaction_for;
-  vector<string> _sorted_chemicals;
-  Map<string, vector<string>> _ingredients_for;
+    _need.resize(n);
+  }
 
-  Map<string, Stock> _stock_of;
+  // ORE needed to make `fuel` FUEL.
+  Stock oreFor(Stock fuel) {
+    std::fill(_need.begin(), _need.end(), 0);
+    _need[_fuel] = fuel;
+    for (auto &r : _reactions) {
+      const Stock to_make = _need[r.result];
+      if (to_make <= 0) {
+        continue;
+      }
+      const Stock repeat = (to_make - 1) / r.yield + 1;  // ceil(to_make / yield)
+      for (int i = r.first_input; i < r.last_input; i++) {
+        _need[_inputs[i].chemical] += repeat * _inputs[i].quantity;
+      }
+    }
+    return _need[_ore];
+  }
 
-  vector<string> gatherIngredientsFor(const string &chemical) {
-    if (chemical == "ORE") {
-      return vector<string>({"ORE"});
+  // Largest amount of FUEL that can be made with `ore` ORE: gallop up from
+  // a lower bound until the ORE runs out, then binary search.
+  Stock maxFuelFor(Stock ore, int *out_probes) {
+    int probes = 0;
+    auto can = [&](Stock fuel) {
+      probes += 1;
+      return oreFor(fuel) <= ore;
+    };
+
+    Stock lo = ore / oreFor(1);  // leftovers only make it cheaper
+    Stock step = std::max(lo / 1024, (Stock)1);
+    while (can(lo + step)) {
+      lo += step;
+      step *= 2;
     }
+    Stock hi = lo + step - 1;
 
-    vector<string> ingredients;
-    auto *r = lookup(_reaction_for, chemical);
-    for (const auto &[chemical, _] : r->ingredients) {
-      ingredients.push_back(chemical);
+    // invariant: can(lo) && !can(hi + 1)
+    while (lo < hi) {
+      Stock m = (hi - lo - 1) / 2 + lo + 1;
+      if (can(m)) {
+        lo = m;
+      } else {
+        hi = m - 1;
+      }
     }
-    std::sort(ingredients.begin(), ingredients.end(),
-              [this](const string &a, const string &b) {
-                return distanceToOre(a) < distanceToOre(b);
-              });
-    return ingredients;
+    *out_probes = probes;
+    return lo;
   }
 
-  int distanceToOre(const string &chemical) const {
-    if (chemical == "ORE") {
-      return 0;
-    }
-    int dist = 0x3f3f3f3f;
-    auto *r = lookup(_reaction_for, chemical);
-    for (auto &[chemical, _] : r->ingredients) {
-      dist = std::min(dist, distanceToOre(chemical));
+ private:
+  struct Input {
+    int chemical;
+    Stock quantity;
+  };
+
+  struct CompiledReaction {
+    int result;
+    Stock yield;
+    int first_input;  // [first_input, last_input) in _inputs
+    int last_input;
+  };
+
+  int idOf(const string &chemical) {
+    auto [it, inserted] = _ids.emplace(chemical, (int)_names.size());
+    if (inserted) {
+      _names.push_back(chemical);
     }
-    return dist + 1;
+    return it->second;
   }
-};
 
-bool canProduceWithATrillionOre(Nanofactory &factory, Stock can_produce) {
-  printf("Try to make %lld FUEL with a trillion ORE... ", can_produce);
-  factory.restart();
-  factory.setOreStock(TRILLION);
-  factory.make(can_produce, "FUEL");
-  const bool can = factory.oreStock() >= 0;
-  printf(factory.oreStock() >= 0 ? "OK\n" : "NOT OK\n");
-  return can;
-}
+  Map<string, int> _ids;
+  vector<string> _names;
+  int _ore;
+  int _fuel;
+
+  vector<CompiledReaction> _reactions;
+  vector<Input> _inputs;
+  vector<Stock> _need;  // scratch for oreFor()
+};
 
 int main() {
   Map<string, Reaction> reaction_for;
@@ -161,30 +206,15 @@ int main() {
     break;
   }
 
-  Nanofactory factory(std::move(reaction_for));
+  Nanofactory factory(reaction_for);
 
-  factory.make(1, "FUEL");
-  const Stock needed_ore_for_one_fuel = -factory.oreStock();
+  const Stock needed_ore_for_one_fuel = factory.oreFor(1);
   printf("%lld ORE necessary for 1 FUEL\n", needed_ore_for_one_fuel);
 
-  Stock lo = TRILLION / needed_ore_for_one_fuel;
-  printf("Lower bound of FUEL from a trillion ORE %lld\n", lo);
-  Stock hi = lo * 2;
-  while (canProduceWithATrillionOre(factory, hi)) {
-    hi *= 2;
-  }
-  printf("Upper bound of FUEL from a trillion ORE %lld\n", hi);
-
-  // invariant: can(lo)
-  while (lo < hi) {
-    Stock m = (hi - lo - 1) / 2 + lo + 1;
-    if (canProduceWithATrillionOre(factory, m)) {
-      lo = m;
-    } else {
-      hi = m - 1;
-    }
-  }
-  printf("Maximum FUEL produced for a trillion ORE %lld\n", lo);
+  int probes = 0;
+  Stock max_fuel = factory.maxFuelFor(TRILLION, &probes);
+  printf("Maximum FUEL produced for a trillion ORE %lld (%d probes)\n",
+         max_fuel, probes);
 
   return 0;
 }
@@ -3,14 +3,13 @@
 #include <cstdio>
 #include <cstring>
 #include <queue>
-#include <unistd.h>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "intcode.h"
 #include "lib.h"
-
-#define MAXN 200
+#include "search.h"
+#include "terminal.h"
 
 Vec moves[] = {
     Vec(0, -1), // NORTH
@@ -35,28 +34,27 @@ int directionToCommand(Vec dir) {
 #define WALL 0
 #define SPACE 1
 #define OXYGEN 2
+#define UNKNOWN 3
 
 struct State {
   State() { reset(Vec(100, 100)); }
 
   Vec pos() const { return droid_pos; }
 
-  int &cell(int x, int y) {
-    assert(x >= 0);
-    assert(y >= 0);
-    assert(x < MAXN);
-    assert(y < MAXN);
-    int &val = map[y][x];
-    min_x = std::min(min_x, x);
-    min_y = std::min(min_y, y);
-    max_x = std::max(max_x, x);
-    max_y = std::max(max_y, y);
-    return val;
-  }
+  int cell(Vec pos) const { return map.get(pos); }
 
-  int &cell(Vec pos) { return cell(pos.x, pos.y); }
+  // The explored map, for dense BFS storage indexed by its cells.
+  const Grid2D<int> &grid() const { return map; }
 
-  bool isExplored(Vec pos) { return cell(pos) < 3; }
+  void setCell(Vec pos, int status) {
+    map.ensure(pos) = status;
+    min_x = std::min(min_x, pos.x);
+    min_y = std::min(min_y, pos.y);
+    max_x = std::max(max_x, pos.x);
+    max_y = std::max(max_y, pos.y);
+  }
+
+  bool isExplored(Vec pos) const { return cell(pos) != UNKNOWN; }
 
   void update(Vec next_pos, int status) {
     switch (status) {
@@ -69,33 +67,31 @@ struct State {
     }
 
     // Update the information about the position the robot tried to move
-    cell(next_pos) = status;
+    setCell(next_pos, status);
   }
 
-  void render() {
+  void render(Terminal &term) {
     for (int y = min_y; y <= max_y; y++) {
       for (int x = min_x; x <= max_x; x++) {
+        char c = ' ';
         if (Vec(x, y) == pos()) {
-          putchar('D');
-          continue;
-        }
-        switch (cell(x, y)) {
-        case WALL:
-          putchar('#');
-          break;
-        case SPACE:
-          putchar('.');
-          break;
-        case OXYGEN:
-          putchar('O');
-          break;
-        default:
-          putchar(' ');
+          c = 'D';
+        } else {
+          switch (cell(Vec(x, y))) {
+          case WALL:
+            c = '#';
+            break;
+          case SPACE:
+            c = '.';
+            break;
+          case OXYGEN:
+            c = 'O';
+            break;
+          }
         }
+        term.put(x - min_x, y - min_y, c);
       }
-      putchar('\n');
     }
-    putchar('\n');
   }
 
   void reset(Vec pos) {
@@ -106,8 +102,8 @@ struct State {
     max_x = droid_pos.x;
     max_y = droid_pos.y;
 
-    memset(map, 0x3f, sizeof(map));
-    cell(droid_pos) = SPACE;
+    map = Grid2D<int>(droid_pos, 1, 1, UNKNOWN);
+    setCell(droid_pos, SPACE);
   }
 
 private:
@@ -116,7 +112,7 @@ private:
   int min_y;
   int max_x;
   int max_y;
-  int map[MAXN][MAXN];
+  Grid2D<int> map;
 };
 
 struct Droid {
@@ -137,9 +133,8 @@ struct Droid {
   }
 
   void render() {
-    state.render();
-    int ms = 11;
-    usleep(ms * 1000);
+    state.render(terminal);
+    terminal.present();
   }
 
   void backtrack(Vec b) {
@@ -199,8 +194,8 @@ struct Droid {
     std::queue<Vec> q;
     Vec pos = state.pos();
     q.push(pos);
-    _parent[pos] = pos;
-    _dist[pos] = 0;
+    _parent.ensure(pos) = pos;
+    _dist.ensure(pos) = 0;
     while (!q.empty()) {
       Vec pos = q.front();
       q.pop();
@@ -222,8 +217,9 @@ struct Droid {
         case SPACE:
         case OXYGEN:
           q.push(next_pos);
-          _parent[next_pos] = pos;
-          _dist[next_pos] = _dist[pos] + 1;
+          int dist = _dist[pos] + 1;
+          _parent.ensure(next_pos) = pos;
+          _dist.ensure(next_pos) = dist;
 
           if (status == 2) {
             oxygen = state.pos();
@@ -238,50 +234,44 @@ struct Droid {
     return oxygen;
   }
 
+  // BFS over the explored map, which is known by now (unlike in explore(),
+  // where the droid has to walk to every cell it expands).
   int fill(Vec oxygen) {
-    std::unordered_map<Vec, int> dist;
+    const Grid2D<int> &grid = state.grid();
+    auto minutes = denseStates<Vec, int>(
+        grid.size(), [&grid](Vec p) { return grid.index(p); });
     int max_dist = 0;
-
-    std::queue<Vec> q;
-    q.push(oxygen);
-
-    dist[oxygen] = 0;
-    while (!q.empty()) {
-      Vec pos = q.front();
-      q.pop();
-
+    bfs(&minutes, oxygen, [&](Vec pos, auto emit) {
       for (int command = 1; command <= 4; command++) {
         Vec next_pos = nextPos(pos, command);
-        int status = state.cell(next_pos);
-        switch (status) {
-        case WALL:
-        case OXYGEN:
-          break;
-        case SPACE:
-          q.push(next_pos);
-          dist[next_pos] = dist[pos] + 1;
-          max_dist = std::max(max_dist, dist[pos] + 1);
-          state.cell(next_pos) = 2;
-
+        if (state.cell(next_pos) == SPACE && emit(next_pos)) {
+          state.setCell(next_pos, OXYGEN);  // known cell: the grid stays put
+          max_dist = std::max(max_dist, minutes.cost(next_pos));
           render();
-          break;
         }
       }
-    }
-
+    });
     return max_dist;
   }
 
+  Terminal terminal;
+
 private:
   State state;
-  std::unordered_map<Vec, Vec> _parent; // parent in the exploration BFS
-  std::unordered_map<Vec, int> _dist;   // exploration BFS distance
+  Grid2D<Vec> _parent; // parent in the exploration BFS
+  Grid2D<int> _dist;   // exploration BFS distance
 
   Program _program;
   CPU _cpu;
 };
 
-int main() {
+// Usage: ./a.out [skip-frames] < in
+//
+// skip-frames drops the frames that come faster than 60 per second instead
+// of waiting for them.
+int main(int argc, char *argv[]) {
+  bool skip_frames = argc > 1 && strcmp(argv[1], "skip-frames") == 0;
+
   Program program;
   Word code;
   while (scanf("%lld", &code)) {
@@ -295,11 +285,15 @@ int main() {
   }
 
   Droid droid(std::move(program));
+  droid.terminal.setSkipFrames(skip_frames);
 
   Vec oxygen = droid.explore();
   printf("Oxygen found at (%d, %d)\n", oxygen.x, oxygen.y);
 
   int max_dist = droid.fill(oxygen);
+  droid.render();
+  droid.terminal.present(true);  // last frame
+  droid.terminal.printStats();
 
   printf("Oxygen found at (%d, %d)\n", oxygen.x, oxygen.y);
   printf("Time to fill with oxygen oxygen %d\n", max_dist);
@@ -1,4 +1,3 @@
-#include <unistd.h>
 #include <algorithm>
 #include <cassert>
 #include <cstdio>
@@ -8,6 +7,7 @@
 
 #include "intcode.h"
 #include "lib.h"
+#include "terminal.h"
 
 using string = std::string;
 using Commands = std::vector<std::string>;
@@ -69,18 +69,9 @@ int countTurns(Vec a, Vec b) {
   return b_pos + 4 - a_pos;
 }
 
-#define MAXN 200
-
 struct Grid {
-  Grid() { memset(map, 0, sizeof(map)); }
-
-  int dummy = 0;
-
   int &set(int x, int y) {
-    if (x < 0 || y < 0 || x >= MAXN || y > MAXN) {
-      return dummy;
-    }
-    int &val = map[y][x];
+    int &val = map.ensure(Vec(x, y));
     min_x = std::min(min_x, x);
     min_y = std::min(min_y, y);
     max_x = std::max(max_x, x);
@@ -90,10 +81,7 @@ struct Grid {
 
   int &set(Vec pos) { return set(pos.x, pos.y); }
 
-  int get(int x, int y) const {
-    if (x < 0 || y < 0 || x > max_x || y > max_y) return 0;
-    return map[y][x];
-  }
+  int get(int x, int y) const { return map.get(Vec(x, y)); }
 
   int get(Vec pos) const { return get(pos.x, pos.y); }
 
@@ -126,27 +114,19 @@ struct Grid {
     return sum;
   }
 
-  void render(Vec bot_pos, Vec bot_dir) const {
+  void render(Terminal &term, Vec bot_pos, Vec bot_dir) const {
     for (int y = min_y; y <= max_y; y++) {
       for (int x = min_x; x <= max_x; x++) {
         Vec pos(x, y);
-        if (pos == bot_pos) {
-          putchar(directionToAscii(bot_dir));
-          continue;
-        }
         int c = get(pos);
-        switch (c) {
-          case 0:
-            putchar(' ');
-            break;
-          default:
-            putchar(c);
-            break;
+        if (pos == bot_pos) {
+          c = directionToAscii(bot_dir);
+        } else if (c == 0) {
+          c = ' ';
         }
+        term.put(x - min_x, y - min_y, (char)c);
       }
-      putchar('\n');
     }
-    putchar('\n');
   }
 
  private:
@@ -154,7 +134,7 @@ struct Grid {
   int min_y = 0;
   int max_x = 0;
   int max_y = 0;
-  int map[MAXN][MAXN];
+  Grid2D<int> map;
 };
 
 // encode commands in terms of A, B, and C
@@ -213,7 +193,10 @@ struct Bot {
     _cpu.loadProgram(_program);
   }
 
-  void render() const { grid.render(bot_pos, bot_dir); }
+  void render() {
+    grid.render(terminal, bot_pos, bot_dir);
+    terminal.present();
+  }
 
   void scan() {
     int y = 0;
@@ -237,8 +220,6 @@ struct Bot {
         x += 1;
       }
       // render();
-      // int ms = 11;
-      // usleep(ms * 1000);
     }
   }
 
@@ -334,6 +315,8 @@ struct Bot {
     return runCommands(commands);
   }
 
+  Terminal terminal;
+
  private:
   Grid grid;
 
@@ -360,6 +343,7 @@ int main() {
   Bot bot(std::move(program));
   bot.scan();
   bot.render();
+  bot.terminal.printStats();
 
   int sum = bot.sumCalibrationParams();
   printf("Calibration params: %d\n", sum);
@@ -2,36 +2,11 @@
 #include <cassert>
 #include <cstdio>
 #include <cstring>
-#include <queue>
-#include <unordered_map>
-#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "lib.h"
-
-struct MemoizationKey {
-  MemoizationKey(uint32_t keychain, Vec pos) : keychain(keychain), pos(pos) {}
-
-  bool operator==(const MemoizationKey &other) const {
-    return keychain == other.keychain && pos == other.pos;
-  }
-
-  uint32_t keychain;
-  Vec pos;
-};
-
-namespace std {
-
-template <> struct hash<MemoizationKey> {
-  size_t operator()(const MemoizationKey &s) const {
-    size_t h = 0;
-    hash_combine(h, s.keychain);
-    hash_combine(h, s.pos);
-    return h;
-  }
-};
-
-} // namespace std
+#include "search.h"
 
 #define NORTH Vec(0, -1)
 #define SOUTH Vec(0, 1)
@@ -42,100 +17,89 @@ Vec cardinals[] = {
     NORTH, EAST, SOUTH, WEST,
 };
 
-struct NearKey {
-  NearKey(char key, int dist, Vec pos) : key(key), dist(dist), pos(pos) {}
+#define MAX_BOTS 4
+#define NUM_KEYS 26
+// Nodes of the key graph: the bot start positions come first, then the keys.
+#define NUM_NODES (MAX_BOTS + NUM_KEYS)
+#define NODE_BITS 5
+
+inline int keyNode(char key) { return MAX_BOTS + (key - 'a'); }
+inline int nodeKey(int node) { return node - MAX_BOTS; }
+
+// A shortest path from a start position or key to another key.
+struct KeyEdge {
+  KeyEdge(int to, int dist, uint32_t doors, uint32_t keys)
+      : to(to), dist(dist), doors(doors), keys(keys) {}
 
-  char key;
-  int dist;
-  Vec pos;
+  int to;          // key node
+  int dist;        // cells walked
+  uint32_t doors;  // keys needed to open the doors along the path
+  uint32_t keys;   // keys lying along the path (excluding both ends)
 };
 
-#define MAXN 100
+// Search state: the keychain in the low 32 bits and NODE_BITS per bot
+// for the node each bot is standing at.
+using SearchState = uint64_t;
 
-struct Vault {
-  Vault() {
-    memset(_keys_to_collect, 0, sizeof(_keys_to_collect));
-    memset(_map, 0, sizeof(_map));
+inline uint32_t stateKeychain(SearchState s) { return (uint32_t)s; }
+
+inline int stateBotNode(SearchState s, int bot) {
+  return (s >> (32 + bot * NODE_BITS)) & ((1 << NODE_BITS) - 1);
+}
+
+inline SearchState makeState(uint32_t keychain, const int *bot_nodes,
+                             int num_bots) {
+  SearchState s = keychain;
+  for (int bot = 0; bot < num_bots; bot++) {
+    s |= (SearchState)bot_nodes[bot] << (32 + bot * NODE_BITS);
   }
+  return s;
+}
 
-  void set(int x, int y, char c) {
-    assert(x < MAXN && y < MAXN);
+// Best known cost of each search state. Any map template with find,
+// operator[] and try_emplace works, e.g. std::unordered_map.
+using CostTable = HashedStates<SearchState, int, FlatMap>;
 
-    _max_x = std::max(_max_x, x);
-    _max_y = std::max(_max_y, y);
+struct Vault {
+  void set(int x, int y, char c) {
+    _width = std::max(_width, x + 1);
+    _height = std::max(_height, y + 1);
 
-    if (c == '@' && _start[0].isNull()) {
+    if (c == '@' && _num_bots == 0) {
       _start[0] = Vec(x, y);
+      _num_bots = 1;
+    }
+    if (c >= 'a' && c <= 'z') {
+      _all_keys = keychainWith(_all_keys, c);
+      _key_pos[c - 'a'] = Vec(x, y);
     }
 
-    _map[y][x] = c;
+    _map.ensure(Vec(x, y)) = c;
   }
 
   void set(Vec pos, char c) { set(pos.x, pos.y, c); }
 
-  int cell(int x, int y) const {
-    if (x < 0 || x > _max_x || y < 0 || y > _max_y) {
-      return '#';
-    }
-    return _map[y][x];
-  }
+  int width() const { return _width; }
+  int height() const { return _height; }
+
+  int cell(int x, int y) const { return _map.get(Vec(x, y)); }
 
   int cell(Vec pos) const { return cell(pos.x, pos.y); }
 
   void render() const {
-    for (int y = 0; y <= _max_y; y++) {
-      for (int x = 0; x <= _max_x; x++) {
+    for (int y = 0; y < height(); y++) {
+      for (int x = 0; x < width(); x++) {
         putchar(cell(x, y));
       }
       putchar('\n');
     }
     putchar('\n');
 
-    for (int bot = 0; bot < _num_bots; bot++) {
-      printf("keys_to_collect[%d]: %d\n", bot,
-             __builtin_popcount(_keys_to_collect[bot]));
-    }
-  }
-
-  uint32_t findReachableKeys(Vec from) const {
-    uint32_t ret = 0;
-
-    std::queue<Vec> q;
-    q.push(from);
-    std::unordered_set<Vec> visited;
-    visited.insert(from);
-
-    while (!q.empty()) {
-      auto v = q.front();
-      q.pop();
-
-      char c = cell(v);
-      if (c >= 'a' && c <= 'z') {
-        ret = keychainWith(ret, c);
-      }
-
-      for (auto &dir : cardinals) {
-        Vec w = v + dir;
-        c = cell(w);
-        if (c == '#') {
-          continue;
-        }
-        if (contains(visited, w)) {
-          continue;
-        }
-        visited.insert(w);
-
-        if (c == '.' || c == '@') {
-          q.push(w);
-        } else if (c >= 'a' && c <= 'z') {
-          q.push(w);
-        } else if (c >= 'A' && c <= 'Z') {
-          q.push(w);
-        }
+    for (int node = 0; node < NUM_NODES; node++) {
+      if (!_edges[node].empty()) {
+        printf("key_graph[%d]: %zu edges\n", node, _edges[node].size());
       }
     }
-
-    return ret;
   }
 
   uint32_t keychainWith(uint32_t keychain, char key) const {
@@ -146,83 +110,34 @@ struct Vault {
     return keychain & (0x1 << (key - 'a'));
   }
 
-  std::vector<NearKey> nearUncollectedKeys(uint32_t keychain, Vec from,
-                                      int bot) const {
-    std::unordered_map<Vec, int> dist;
-    std::vector<NearKey> ret;
-
-    std::queue<Vec> q;
-    q.push(from);
-    dist.insert(std::make_pair(from, 0));
-    while (!q.empty()) {
-      auto v = q.front();
-      q.pop();
-
-      char c = cell(v);
-      if (c >= 'a' && c <= 'z') {
-        if (!containsKey(keychain, c)) {
-          // Found a uncollected key!
-          ret.push_back(NearKey(c, dist[v], v));
-          continue;
-        }
+  // BFS from `from` ignoring doors, recording for every reachable key the
+  // doors and keys found along the way. The mazes are (nearly) trees, so
+  // the shortest path is the only sensible path to each key.
+  void exploreFrom(int node, Vec from) {
+    auto index = [this](Vec p) { return _map.index(p); };
+    auto dist = denseStates<Vec, int>(_map.size(), index);
+    std::vector<uint32_t> doors(_map.size(), 0);
+    std::vector<uint32_t> keys(_map.size(), 0);
+
+    bfs(&dist, from, [&](Vec v, auto emit) {
+      char c = _map[v];
+      uint32_t v_doors = doors[index(v)];
+      uint32_t v_keys = keys[index(v)];
+      if (c >= 'a' && c <= 'z' && dist.cost(v) > 0) {
+        _edges[node].emplace_back(keyNode(c), dist.cost(v), v_doors, v_keys);
+        v_keys = keychainWith(v_keys, c);
+      } else if (c >= 'A' && c <= 'Z') {
+        v_doors = keychainWith(v_doors, tolower(c));
       }
 
       for (auto &dir : cardinals) {
-        Vec w = v + dir;
-        c = cell(w);
-        if (c == '#') {
-          continue;
-        }
-        if (lookup(dist, w)) {
-          continue; // visited
-        }
-        dist[w] = dist[v] + 1;
-
-        if (c == '.' || c == '@') {
-          q.push(w);
-        } else if (c >= 'A' && c <= 'Z') {
-          // another bot will find the key for door c if this the key that
-          // opens this door is not part of the keys this bot has to collect
-          char key = tolower(c);
-          if ((_num_bots > 1 && !containsKey(_keys_to_collect[bot], key)) ||
-              containsKey(keychain, key)) {
-            q.push(w);
-          }
-        } else {
-          assert(c >= 'a' && c <= 'z');
-          q.push(w);
+        Vec u = v + dir;
+        if (_map[u] != '#' && emit(u)) {
+          doors[index(u)] = v_doors;
+          keys[index(u)] = v_keys;
         }
       }
-    }
-
-    return ret;
-  }
-
-  // the minimum cost of collecting all keys reachable by `bot`
-  // from `from` while holding all keys in `keychain`
-  int minCostToAll(uint32_t keychain, Vec from, int bot) {
-    if (keychain == _keys_to_collect[bot]) {
-      // has all keys already
-      return 0;
-    }
-    MemoizationKey memo_key(keychain, from);
-    if (auto *memo = lookup(_memoized, memo_key)) {
-      return *memo;
-    }
-    auto &memo = _memoized[memo_key];
-
-    // find the nearest uncollected keys
-    auto near_keys = nearUncollectedKeys(keychain, from, bot);
-
-    int min = 0x3f3f3f3f;
-    for (auto &near_key : near_keys) {
-      int cost =
-          near_key.dist +
-          minCostToAll(keychainWith(keychain, near_key.key), near_key.pos, bot);
-      min = std::min(min, cost);
-    }
-
-    return memo = min;
+    });
   }
 
   void splitInFour() {
@@ -246,34 +161,79 @@ struct Vault {
     _num_bots = 4;
   }
 
+  // Builds the key graph: one BFS from every start position and every key.
   void explore() {
     for (int bot = 0; bot < _num_bots; bot++) {
-      _keys_to_collect[bot] = findReachableKeys(_start[bot]);
+      exploreFrom(bot, _start[bot]);
+    }
+    for (int k = 0; k < NUM_KEYS; k++) {
+      if (containsKey(_all_keys, 'a' + k)) {
+        exploreFrom(keyNode('a' + k), _key_pos[k]);
+      }
     }
   }
 
+  // Dijkstra over (bot positions, keychain) on the key graph. Bots are
+  // moved one at a time, so a key collected by one bot opens doors for all
+  // the others. Edges are hundreds of cells long, hence the radix heap.
   int collectAllKeys() {
-    uint32_t keychain = 0;
-    int min_total_cost = 0;
+    CostTable best;
+    RadixHeap<SearchState, int> queue;
+
+    int bot_nodes[MAX_BOTS];
     for (int bot = 0; bot < _num_bots; bot++) {
-      _memoized.clear();
-      int min_cost_for_bot = minCostToAll(keychain, _start[bot], bot);
-      printf("min_cost_for_bot %d\n", min_cost_for_bot);
-      min_total_cost += min_cost_for_bot;
+      bot_nodes[bot] = bot;
+    }
+    SearchState source = makeState(0, bot_nodes, _num_bots);
+
+    auto neighbours = [&](SearchState s, auto emit) {
+      const uint32_t keychain = stateKeychain(s);
+      int bot_nodes[MAX_BOTS];
+      for (int bot = 0; bot < _num_bots; bot++) {
+        bot_nodes[bot] = stateBotNode(s, bot);
+      }
+      for (int bot = 0; bot < _num_bots; bot++) {
+        const int from = bot_nodes[bot];
+        for (auto &edge : _edges[from]) {
+          char key = 'a' + nodeKey(edge.to);
+          if (containsKey(keychain, key) ||
+              (edge.doors & ~keychain) != 0 ||
+              (edge.keys & ~keychain) != 0) {
+            // key already collected, path blocked by a locked door, or an
+            // uncollected key lies on the way (reached via a shorter edge)
+            continue;
+          }
+
+          bot_nodes[bot] = edge.to;
+          emit(makeState(keychainWith(keychain, key), bot_nodes, _num_bots),
+               edge.dist);
+          bot_nodes[bot] = from;
+        }
+      }
+    };
+    auto done = [&](SearchState s) { return stateKeychain(s) == _all_keys; };
+
+    auto found = dijkstra(&best, &queue, source, neighbours, done);
+    if (!found) {
+      return -1;  // some key is unreachable
     }
-    return min_total_cost;
+    printf("explored %zu states\n", best.size());
+    return best.cost(*found);
   }
 
-private:
-  Vec _start[4];                // start position of the bot
-  uint32_t _keys_to_collect[4]; // keys each bot has to collect
-  int _num_bots = 1;
+ private:
+  Vec _start[MAX_BOTS];  // start position of the bots
+  int _num_bots = 0;
 
-  int _max_x = 0;
-  int _max_y = 0;
-  int _map[MAXN][MAXN];
+  uint32_t _all_keys = 0;
+  Vec _key_pos[NUM_KEYS];
+  std::vector<KeyEdge> _edges[NUM_NODES];
 
-  std::unordered_map<MemoizationKey, int> _memoized;
+  // Walls outside of the map, and in the border, so that BFS can step
+  // anywhere next to an open cell without bounds checks.
+  Grid2D<char> _map{0, 0, '#', 1};
+  int _width = 0;
+  int _height = 0;
 };
 
 Vault vault;
@@ -294,7 +254,7 @@ int main() {
   }
 
   vault.splitInFour(); // comment to get phase 1
-  vault.explore();     // computes reachable keys
+  vault.explore();     // builds the key graph
 
   vault.render();
 
@@ -1,14 +1,12 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdio>
-#include <queue>
 #include <string>
-#include <unordered_map>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "lib.h"
+#include "search.h"
 
 #define NORTH Vec(0, -1)
 #define SOUTH Vec(0, 1)
@@ -19,13 +17,23 @@ Vec cardinals[] = {
     NORTH, EAST, SOUTH, WEST,
 };
 
-using WorldPos = std::pair<Vec, int>;
 using Portal = std::pair<std::string, Vec>;
 
-struct Donut {
-  Donut() { memset(_map, 0, sizeof(_map)); }
+struct PortalNode {
+  Vec pos;
+  int level_delta;  // -1 for outer portals, +1 for inner portals
+};
+
+struct PortalEdge {
+  int to;
+  int dist;
+  int level_delta;  // 0 when walking, +/-1 when going through the portal
+};
 
-#define MAXN 250
+struct Donut {
+  // The map is read as it comes, growing the grid; its border of empty cells
+  // lets findExits() look one cell past the last row and column.
+  Donut() : _map(0, 0, 0, 1) {}
 
   void findExits(int width, int height) {
     char p[3];
@@ -33,7 +41,7 @@ struct Donut {
 
     for (int y = 1; y < height; y++) {
       for (int x = 1; x < width; x++) {
-        char c = _map[y][x];
+        char c = _map[Vec(x, y)];
         if (!isalpha(c)) {
           continue;
         }
@@ -43,49 +51,49 @@ struct Donut {
                            : inner;
 
         if (y == 1) {
-          p[0] = _map[0][x];
-          p[1] = _map[1][x];
+          p[0] = _map[Vec(x, 0)];
+          p[1] = _map[Vec(x, 1)];
           chosen.emplace_back(p, Vec(x, 2));
           continue;
         }
 
         if (x == 1) {
-          p[0] = _map[y][0];
-          p[1] = _map[y][1];
+          p[0] = _map[Vec(0, y)];
+          p[1] = _map[Vec(1, y)];
           chosen.emplace_back(p, Vec(2, y));
           continue;
         }
 
-        char prev_x = _map[y][x - 1];
+        char prev_x = _map[Vec(x - 1, y)];
         if (prev_x && prev_x == '.') {
-          p[0] = _map[y][x];
-          p[1] = _map[y][x + 1];
+          p[0] = _map[Vec(x, y)];
+          p[1] = _map[Vec(x + 1, y)];
           chosen.emplace_back(p, Vec(x - 1, y));
           continue;
         }
 
-        char prev_y = _map[y - 1][x];
+        char prev_y = _map[Vec(x, y - 1)];
         if (prev_y && prev_y == '.') {
-          p[0] = _map[y][x];
-          p[1] = _map[y + 1][x];
+          p[0] = _map[Vec(x, y)];
+          p[1] = _map[Vec(x, y + 1)];
           chosen.emplace_back(p, Vec(x, y - 1));
           continue;
         }
 
-        char next_x = _map[y][x + 1];
+        char next_x = _map[Vec(x + 1, y)];
         if (next_x && next_x == '.') {
           char p[3];
-          p[0] = _map[y][x - 1];
-          p[1] = _map[y][x];
+          p[0] = _map[Vec(x - 1, y)];
+          p[1] = _map[Vec(x, y)];
           chosen.emplace_back(p, Vec(x + 1, y));
           continue;
         }
 
-        char next_y = _map[y + 1][x];
+        char next_y = _map[Vec(x, y + 1)];
         if (next_y && next_y == '.') {
           char p[3];
-          p[0] = _map[y - 1][x];
-          p[1] = _map[y][x];
+          p[0] = _map[Vec(x, y - 1)];
+          p[1] = _map[Vec(x, y)];
           chosen.emplace_back(p, Vec(x, y + 1));
           continue;
         }
@@ -98,69 +106,97 @@ struct Donut {
       } else if (o.first == "ZZ") {
         ZZ = o.second;
       }
-      for (auto &i : inner) {
-        if (o.first == i.first && o.second != i.second) {
-          outer_exits[o.second] = i.second;
-          inner_exits[i.second] = o.second;
-        }
-      }
     }
   }
 
-  int findShortestPath(bool multi_worlds) {
-    std::unordered_set<WorldPos> visited;
-    std::unordered_map<WorldPos, int> dist;
-    std::queue<WorldPos> q;
-    std::vector<WorldPos> border;
-
-    WorldPos source(AA, 0); // 0 is the outermost world
-    visited.insert(source);
-    dist[source] = 0;
-    q.push(source);
-
-    while (!q.empty()) {
-      auto v = q.front();
-      q.pop();
-
-      if (v == std::make_pair(ZZ, 0)) {
-        // found ZZ in the outermost world
-        return dist[v];
+  int nodeAt(Vec pos) const {
+    for (int i = 0; i < (int)nodes.size(); i++) {
+      if (nodes[i].pos == pos) {
+        return i;
       }
+    }
+    return -1;
+  }
 
-      border.clear();
-      for (auto &dir : cardinals) {
-        border.emplace_back(v.first + dir, v.second);
-      }
-      // edge to outer worlds
-      if (v.second > 0) {
-        if (Vec *exit = lookup(outer_exits, v.first)) {
-          border.emplace_back(*exit, multi_worlds ? v.second - 1 : 0);
+  // Compresses the maze into a weighted graph between portal endpoints:
+  // one BFS per endpoint finds the walking distance to every other
+  // endpoint, and every portal adds a 1-step edge that changes the level.
+  void buildPortalGraph() {
+    for (auto &o : outer) {
+      nodes.push_back(PortalNode{o.second, -1});
+    }
+    for (auto &i : inner) {
+      nodes.push_back(PortalNode{i.second, +1});
+    }
+    source = nodeAt(AA);
+    target = nodeAt(ZZ);
+    edges.resize(nodes.size());
+
+    auto dist = denseStates<Vec, int>(
+        _map.size(), [this](Vec p) { return _map.index(p); });
+    for (int from = 0; from < (int)nodes.size(); from++) {
+      dist.clear();
+      Vec start = nodes[from].pos;
+      bfs(&dist, start, [this](Vec v, auto emit) {
+        for (auto &dir : cardinals) {
+          Vec w = v + dir;
+          if (_map[w] == '.') {
+            emit(w);
+          }
+        }
+      });
+      for (int to = 0; to < (int)nodes.size(); to++) {
+        Vec p = nodes[to].pos;
+        if (to != from && dist.reached(p)) {
+          edges[from].push_back(PortalEdge{to, dist.cost(p), 0});
         }
       }
-      // edge to inner worlds
-      if (Vec *exit = lookup(inner_exits, v.first)) {
-        border.emplace_back(*exit, multi_worlds ? v.second + 1 : 0);
+    }
+
+    // outer portal o is node o, inner portal i is node outer.size() + i
+    const int num_outer = (int)outer.size();
+    for (int o = 0; o < num_outer; o++) {
+      for (int i = 0; i < (int)inner.size(); i++) {
+        if (outer[o].first == inner[i].first) {
+          edges[o].push_back(PortalEdge{num_outer + i, 1, -1});
+          edges[num_outer + i].push_back(PortalEdge{o, 1, +1});
+        }
       }
+    }
+  }
 
-      for (auto &w : border) {
-        char c = _map[w.first.y][w.first.x];
-        if (c != '.' || contains(visited, w)) {
+  // Dijkstra over (portal endpoint, level), numbered level * num_nodes +
+  // node. A shortest path never needs to go deeper than the number of
+  // portals, which bounds the search even when ZZ is unreachable.
+  int findShortestPath(bool multi_worlds) {
+    const int num_nodes = (int)nodes.size();
+    const int max_level = multi_worlds ? (int)inner.size() : 0;
+    auto dist = denseStates<int, int>(num_nodes * (max_level + 1),
+                                      [](int v) { return (size_t)v; });
+    RadixHeap<int, int> queue;
+
+    auto neighbours = [&](int v, auto emit) {
+      const int node = v % num_nodes;
+      const int level = v / num_nodes;
+      for (auto &e : edges[node]) {
+        int w_level = multi_worlds ? level + e.level_delta : 0;
+        if (w_level < 0 || w_level > max_level) {
           continue;
         }
-        visited.insert(w);
-        dist[w] = dist[v] + 1;
-        q.push(w);
+        emit(w_level * num_nodes + e.to, e.dist);
       }
-    }
+    };
+    // ZZ in the outermost world, level 0
+    auto found = dijkstra(&dist, &queue, source, neighbours,
+                          [&](int v) { return v == target; });
 
-    assert(false);
-    return 0x3f3f3f3f;
+    return found ? dist.cost(*found) : -1;  // -1: no path
   }
 
   void render(int width, int height) {
     for (int y = 0; y < height; y++) {
       for (int x = 0; x < width; x++) {
-        putchar(_map[y][x]);
+        putchar(_map.get(Vec(x, y)));
       }
       putchar('\n');
     }
@@ -171,9 +207,11 @@ struct Donut {
   Vec ZZ;
   std::vector<Portal> inner;
   std::vector<Portal> outer;
-  std::unordered_map<Vec, Vec> inner_exits;
-  std::unordered_map<Vec, Vec> outer_exits;
-  char _map[MAXN][MAXN];
+  std::vector<PortalNode> nodes;
+  std::vector<std::vector<PortalEdge>> edges;
+  int source = -1;
+  int target = -1;
+  Grid2D<char> _map;
 };
 
 Donut donut;
@@ -195,11 +233,12 @@ int main() {
     width = std::max(width, x + 1);
     height = std::max(height, y + 1);
 
-    donut._map[y][x] = c;
+    donut._map.ensure(Vec(x, y)) = c;
     x += 1;
   }
 
   donut.findExits(width, height);
+  donut.buildPortalGraph();
   donut.render(width, height);
 
   // change to false for first phase of the problem
@@ -1,60 +1,137 @@
 #include <cassert>
+#include <chrono>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <unordered_map>
+#include <vector>
 
 #include "intcode.h"
+#include "lib.h"
+
+struct Packet {
+  long long dest;
+  Word x;
+  Word y;
+  long long sent_tick;
+};
 
 struct NAT {
-  void recv(long long x, long long y) {
+  void recv(const Packet &p) {
+    if (!received) {
+      printf("NAT: first Y received by NAT: %lld\n", p.y);
+    }
     if (!received) {
-      printf("NAT: first Y received by NAT: %lld\n", y);
+      first_y = p.y;
     }
     received = true;
-    received_x = x;
-    received_y = y;
+    received_x = p.x;
+    received_y = p.y;
   }
 
-  void sendLastPacketTo(CPU &dest) {
+  // Returns false once the same Y is sent twice in a row.
+  bool sendLastPacket(long long tick, Packet *out) {
     assert(hasReceivedPacket());
     printf("NAT: send[%lld] %lld %lld\n", 0ll, received_x, received_y);
-    dest.pushInput(received_x);
-    dest.pushInput(received_y);
+    *out = Packet{0, received_x, received_y, tick};
 
     if (sent && received_y == sent_y) {
       printf("NAT: sending the same Y in a row: %lld\n", received_y);
-      exit(0);
+      return false;
     }
     sent = true;
     sent_y = received_y;
+    return true;
   }
 
   bool hasReceivedPacket() const { return received; }
 
+  long long firstY() const { return first_y; }
+  long long lastSentY() const { return sent_y; }
+
  private:
   bool received = false;
+  long long first_y = 0;
   long long received_x;
   long long received_y;
 
   bool sent = false;
-  long long sent_y;
+  long long sent_y = 0;
+};
+
+// Nodes, the program each one runs and where packets for each address go.
+struct Topology {
+  static Topology uniform(const Program &program, int num_nodes) {
+    Topology t;
+    t.programs.assign(num_nodes, program);
+    for (int i = 0; i < num_nodes; i++) {
+      t.routes[i] = i;
+    }
+    return t;
+  }
+
+  // Like uniform(), but address a lives on node (a + offset) % num_nodes.
+  static Topology rotated(const Program &program, int num_nodes, int offset) {
+    Topology t = uniform(program, num_nodes);
+    for (int i = 0; i < num_nodes; i++) {
+      t.routes[i] = (i + offset) % num_nodes;
+    }
+    return t;
+  }
+
+  int numNodes() const { return (int)programs.size(); }
+
+  std::vector<Program> programs;  // per node
+  std::unordered_map<long long, int> routes;  // address -> node
+  long long nat_address = 255;
 };
 
+template <typename K>
+void printHistogram(const char *title, const std::map<K, long long> &hist) {
+  printf("%s:\n", title);
+  for (auto &[bucket, count] : hist) {
+    printf("  %8lld: %lld\n", (long long)bucket, count);
+  }
+}
+
+// Simulates a cluster of message-passing Intcode machines in lockstep
+// ticks. In each tick every node consumes the packets delivered to it at the
+// end of the previous tick (or a -1), runs until it blocks on input and
+// queues what it sends in its own outbox. Nodes only touch their own state
+// during a tick, so they run in parallel, one range of nodes per thread;
+// delivery then happens in node order, which makes the simulation
+// deterministic for any thread count.
 struct Network {
-  explicit Network(Program program) : _program(std::move(program)) {
-    for (auto &cpu : _cpu) {
-      cpu.loadProgram(_program);
+  Network(Topology topology, int num_threads)
+      : _topology(std::move(topology)),
+        _nodes(_topology.numNodes()),
+        _pool(num_threads),
+        _grain((_topology.numNodes() + _pool.size() - 1) / _pool.size()) {
+    for (int i = 0; i < (int)_nodes.size(); i++) {
+      _nodes[i].cpu.loadProgram(_topology.programs[i]);
     }
   }
 
   void assignAddresses() {
+    // every node owns exactly one address
+    std::vector<long long> address(_nodes.size(), -1);
+    for (auto &[addr, node] : _topology.routes) {
+      assert(0 <= node && node < (int)_nodes.size());
+      assert(address[node] == -1);
+      address[node] = addr;
+    }
+
     // give addresses to all CPUs
-    for (int i = 0; i < 50; i++) {
-      CPU &cpu = _cpu[i];
+    for (int i = 0; i < (int)_nodes.size(); i++) {
+      CPU &cpu = _nodes[i].cpu;
       cpu.run();
       assert(cpu.status == PENDING_IN);
       assert(cpu.op == IN);
 
       // give it the address
-      cpu.pushInput(i);
+      assert(address[i] != -1);
+      cpu.pushInput(address[i]);
 
       // ensure it consumes the address
       cpu.tick();
@@ -66,76 +143,165 @@ struct Network {
 
   // return true if network is idle
   bool tick() {
-    bool sent_packet = false;
-    int stuck_count = 0;
-
-    for (int i = 0; i < 50; i++) {
-      CPU &cpu = _cpu[i];
-      assert(cpu.status != HALTED);
-
-      // If there's a buffered package and the CPU is in PENDING_IN,
-      // ensure the package is consume before continuing.
-      if (cpu.status == PENDING_IN && cpu.hasInput()) {
-        bool consumed = cpu.consumePacket();
-        assert(consumed);
+    parallel_for_chunks(
+        0, (int)_nodes.size(),
+        [this](int begin, int end) {
+          for (int i = begin; i < end; i++) {
+            runNode(i);
+          }
+        },
+        _grain, &_pool);
+
+    // deliver in node order
+    bool idle = true;
+    long long sent = 0;
+    for (auto &node : _nodes) {
+      idle = idle && node.idle;
+      for (auto &p : node.outbox) {
+        deliver(p);
       }
+      sent += node.outbox.size();
+      node.outbox.clear();
+    }
+    _throughput[sent] += 1;
+    _tick += 1;
+    return idle && sent == 0;
+  }
+
+  // Runs until the NAT sends the same Y twice in a row, or for max_ticks
+  // ticks if that is positive.
+  void run(long long max_ticks = 0) {
+    assignAddresses();
 
-      cpu.runUntilIO();  // run until IN or OUT
+    auto start = std::chrono::steady_clock::now();
+    while (max_ticks <= 0 || _tick < max_ticks) {
+      bool network_idle = tick();
 
-      // if found an unfulfilled IN, give it a -1
-      if (cpu.status == PENDING_IN) {
-        cpu.pushInput(-1);
-        stuck_count += 1;
-        continue;
+      if (network_idle && _nat.hasReceivedPacket()) {
+        // sent at the end of the tick that just ran, like the nodes' packets
+        Packet p;
+        bool go_on = _nat.sendLastPacket(_tick - 1, &p);
+        deliver(p);
+        if (!go_on) {
+          break;
+        }
       }
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    mergeLatencies();
 
-      // if found an OUT, send that as a package
-      if (cpu.hasOutput()) {
-        cpu.runUntilOutput();  // x
-        cpu.runUntilOutput();  // y
+    printf("%lld ticks, %lld packets (%lld dropped) in %.3fs (%.0f packets/s)\n",
+           _tick, _sent, _dropped, elapsed.count(),
+           _sent / elapsed.count());
+    printHistogram("latency (ticks) -> packets", _latency);
+    printHistogram("packets per tick -> ticks", _throughput);
+  }
+
+  const NAT &nat() const { return _nat; }
+
+ private:
+  struct Node {
+    CPU cpu;
+    std::vector<Packet> inbox;
+    std::vector<Packet> outbox;
+    bool idle = false;  // got no packets and sent none in the last tick
+    std::map<long long, long long> latency;  // ticks -> packets received
+  };
+
+  void runNode(int i) {
+    Node &node = _nodes[i];
+    CPU &cpu = node.cpu;
+    assert(cpu.status != HALTED);
+
+    node.idle = node.inbox.empty();
+    if (node.inbox.empty()) {
+      cpu.pushInput(-1);
+    }
+    for (auto &p : node.inbox) {
+      node.latency[_tick - p.sent_tick] += 1;
+      cpu.pushInput(p.x);
+      cpu.pushInput(p.y);
+    }
+    node.inbox.clear();
+
+    // run until blocked on input, collecting the packets sent
+    for (;;) {
+      cpu.runUntilOutput();
+      if (cpu.status != PAUSED) {
+        break;
+      }
+      if (cpu.output().size() == 3) {
         long long addr = cpu.consumeOutput();
         long long x = cpu.consumeOutput();
         long long y = cpu.consumeOutput();
-
-        printf("%d: send[%lld] %lld %lld\n", i, addr, x, y);
-        if (addr < 50) {
-          CPU &dest = _cpu[addr];
-          assert(dest.status != HALTED);
-          dest.pushInput(x);
-          dest.pushInput(y);
-        }
-        if (addr == 255) {
-          _nat.recv(x, y);
-        }
-        sent_packet = true;
-        continue;
+        node.outbox.push_back(Packet{addr, x, y, _tick});
+        node.idle = false;
       }
     }
-
-    return !sent_packet && stuck_count == 50;
   }
 
-  void run() {
-    assignAddresses();
+  void deliver(const Packet &p) {
+    _sent += 1;
+    if (p.dest == _topology.nat_address) {
+      _nat.recv(p);
+    } else if (int *node = lookupRoute(p.dest)) {
+      _nodes[*node].inbox.push_back(p);
+    } else {
+      _dropped += 1;
+    }
+  }
 
-    for (;;) {
-      bool network_idle = tick();
+  int *lookupRoute(long long addr) {
+    auto it = _topology.routes.find(addr);
+    return it != _topology.routes.end() ? &it->second : nullptr;
+  }
 
-      if (network_idle) {
-        if (_nat.hasReceivedPacket()) {
-          _nat.sendLastPacketTo(_cpu[0]);
-        }
+  // Per-node histograms avoid sharing state between workers.
+  void mergeLatencies() {
+    for (auto &node : _nodes) {
+      for (auto &[ticks, count] : node.latency) {
+        _latency[ticks] += count;
       }
+      node.latency.clear();
     }
   }
 
  private:
+  Topology _topology;
+  std::vector<Node> _nodes;
+  ThreadPool _pool;
+  int _grain;  // nodes per chunk
   NAT _nat;
-  CPU _cpu[50];
-  Program _program;
+  long long _tick = 0;
+  long long _sent = 0;
+  long long _dropped = 0;
+  std::map<long long, long long> _latency;     // ticks -> packets
+  std::map<long long, long long> _throughput;  // packets per tick -> ticks
 };
 
-int main() {
+// Usage: ./a.out [nodes=N] [threads=T] [max_ticks=M] [check] < in
+//
+// threads: one per hardware thread by default.
+// check: also runs with the addresses rotated over the nodes, and with one
+// thread, and checks that the NAT sees the same Ys.
+int main(int argc, char *argv[]) {
+  int num_nodes = 50;
+  int num_threads = 0;
+  long long max_ticks = 0;
+  bool check = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "check") == 0) {
+      check = true;
+    } else if (strncmp(argv[i], "nodes=", 6) == 0) {
+      num_nodes = atoi(argv[i] + 6);
+    } else if (strncmp(argv[i], "threads=", 8) == 0) {
+      num_threads = atoi(argv[i] + 8);
+    } else if (strncmp(argv[i], "max_ticks=", 10) == 0) {
+      max_ticks = atoll(argv[i] + 10);
+    }
+  }
+
   Program program;
   Word code;
   while (scanf("%lld", &code)) {
@@ -148,8 +314,16 @@ int main() {
     }
   }
 
-  Network net(std::move(program));
-  net.run();
+  Network net(Topology::uniform(program, num_nodes), num_threads);
+  net.run(max_ticks);
+
+  if (check) {
+    Network rotated(Topology::rotated(program, num_nodes, 7), 1);
+    rotated.run(max_ticks);
+    assert(rotated.nat().firstY() == net.nat().firstY());
+    assert(rotated.nat().lastSentY() == net.nat().lastSentY());
+    printf("check: OK\n");
+  }
 
   return 0;
 }
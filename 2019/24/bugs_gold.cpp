@@ -1,7 +1,9 @@
 #include <unistd.h>
 #include <cassert>
 #include <cstdio>
-#include <unordered_map>
+#include <cstring>
+#include <deque>
+#include <vector>
 
 #include "lib.h"
 
@@ -17,9 +19,11 @@ Vec cardinals[] = {
     WEST,
 };
 
-//                level -> grid
-std::unordered_map<int, uint32_t> grid_at_level;
-std::unordered_map<int, uint32_t> tmp_grid_at_level;
+// Levels from the uppermost (outermost) to the lowermost (innermost) grid.
+// Bugs spread at most one level per minute, so the deque grows by at most
+// one level at each end per minute.
+std::deque<uint32_t> levels;
+int uppermost = 0;  // level of levels.front()
 
 bool hasBugOnGrid(uint32_t grid, int i) {
   assert(i >= 0 && i < 25);
@@ -52,103 +56,109 @@ void renderGrid(uint32_t grid) {
   // usleep(200 * 1000);
 }
 
-void renderLevels(int uppermost, int lowermost) {
-  for (int l = uppermost; l <= lowermost; l++) {
-    printf("Depth %d:\n", l);
-    renderGrid(grid_at_level[l]);
+void renderLevels() {
+  for (int i = 0; i < (int)levels.size(); i++) {
+    printf("Depth %d:\n", uppermost + i);
+    renderGrid(levels[i]);
   }
 }
 
-uint32_t gridAtLevel(int level) {
-  if (auto *upper_grid = lookup(grid_at_level, level)) {
-    return *upper_grid;
-  }
-  return 0;
-}
-
+#define GRID_MASK 0x1ffffffu
+#define CENTER_MASK (0x1u << 12u)
 #define FIRST_ROW_MASK 0x1fu
 #define LAST_ROW_MASK (FIRST_ROW_MASK << 20u)
 #define FIRST_COL_MASK 0x108421u
 #define LAST_COL_MASK (FIRST_COL_MASK << 4u)
 
-int countMasked(uint32_t grid, uint32_t mask) {
-  return __builtin_popcount(grid & mask);
-}
-
-int countAdjacent(int level, Vec v) {
-  uint32_t grid = gridAtLevel(level);
-
-  int count = 0;
-  for (auto dir : cardinals) {
-    Vec w = v + dir;
-    uint32_t upper_grid = gridAtLevel(level - 1);
-    if (w.y == -1) {
-      if (hasBugOnGrid(upper_grid, Vec(1, 2))) {
-        count += 1;
-      }
-    } else if (w.y == 5) {
-      if (hasBugOnGrid(upper_grid, Vec(3, 2))) {
-        count += 1;
-      }
-    } else if (w.x == -1) {
-      if (hasBugOnGrid(upper_grid, Vec(2, 1))) {
-        count += 1;
-      }
-    } else if (w.x == 5) {
-      if (hasBugOnGrid(upper_grid, Vec(2, 3))) {
-        count += 1;
-      }
-    } else if (w == Vec(2, 2)) {
-      uint32_t lower_grid = gridAtLevel(level + 1);
-      if (v == Vec(1, 2)) {
-        count += countMasked(lower_grid, FIRST_ROW_MASK);
-      } else if (v == Vec(2, 3)) {
-        count += countMasked(lower_grid, LAST_COL_MASK);
-      } else if (v == Vec(3, 2)) {
-        count += countMasked(lower_grid, LAST_ROW_MASK);
-      } else if (v == Vec(2, 1)) {
-        count += countMasked(lower_grid, FIRST_COL_MASK);
-      }
-    } else if (hasBugOnGrid(grid, w)) {
-      count += 1;
-    }
+// Cells next to the center tile, which border a whole edge of the lower grid.
+#define INNER_NORTH 7u  // (2, 1)
+#define INNER_WEST 11u  // (1, 2)
+#define INNER_EAST 13u  // (3, 2)
+#define INNER_SOUTH 17u // (2, 3)
+
+// 8 levels per AVX2 register (GCC/clang vector extension). Without -mavx2
+// a Lanes passed or returned by value changes the calling convention, so
+// Lanes only go in and out of functions by pointer.
+typedef uint32_t Lanes __attribute__((vector_size(32)));
+#define LANES 8
+
+#define ALWAYS_INLINE static inline __attribute__((always_inline))
+
+// Next state of `grid` given the grids right above and below it, computed
+// for every cell at once. T is uint32_t or Lanes.
+template <typename T>
+ALWAYS_INLINE void stepGrid(const T *upper_p, const T *grid_p,
+                            const T *lower_p, T *next) {
+  const T upper = *upper_p, grid = *grid_p, lower = *lower_p;
+
+  // counts of 0..3, and overflow for cells that saw 4 or more neighbours
+  BitCounter<T, 2> n;
+
+  // same level
+  n.add((grid << 5u) & GRID_MASK);
+  n.add(grid >> 5u);
+  n.add((grid << 1u) & ~FIRST_COL_MASK & GRID_MASK);
+  n.add((grid >> 1u) & ~LAST_COL_MASK);
+
+  // upper level: edge cells see the cells around the upper center tile,
+  // spread to all-ones when set
+  const T north = -((upper >> INNER_NORTH) & 1u);
+  const T south = -((upper >> INNER_SOUTH) & 1u);
+  const T west = -((upper >> INNER_WEST) & 1u);
+  const T east = -((upper >> INNER_EAST) & 1u);
+  n.add((north & FIRST_ROW_MASK) | (south & LAST_ROW_MASK));
+  n.add((west & FIRST_COL_MASK) | (east & LAST_COL_MASK));
+
+  // lower level: cells around the center see a whole edge of the lower grid
+  for (unsigned k = 0; k < 5; k++) {
+    n.add((((lower >> k) & 1u) << INNER_NORTH) |
+          (((lower >> (20u + k)) & 1u) << INNER_SOUTH) |
+          (((lower >> (5u * k)) & 1u) << INNER_WEST) |
+          (((lower >> (5u * k + 4u)) & 1u) << INNER_EAST));
   }
 
-  return count;
+  T exactly_one, exactly_two;
+  n.equals(1, &exactly_one);
+  n.equals(2, &exactly_two);
+  *next = ((grid & exactly_one) | (~grid & (exactly_one | exactly_two))) &
+          GRID_MASK & ~CENTER_MASK;
 }
 
-uint32_t iterateGrid(int level, uint32_t grid) {
-  uint32_t new_grid = 0;
-  for (int y = 0; y < 5; y++) {
-    for (int x = 0; x < 5; x++) {
-      if (x == 2 && y == 2) continue;
-      Vec pos(x, y);
-      bool new_value = false;
-      if (hasBugOnGrid(grid, pos)) {
-        new_value = countAdjacent(level, pos) == 1;
-      } else {
-        int adj = countAdjacent(level, pos);
-        new_value = (adj == 1 || adj == 2);
-      }
-      if (new_value) {
-        new_grid |= (0x1 << (pos.y * 5 + pos.x));
-      }
-    }
+void iterate() {
+  if (levels.front() != 0) {
+    levels.push_front(0);
+    uppermost -= 1;
+  }
+  if (levels.back() != 0) {
+    levels.push_back(0);
   }
-  return new_grid;
-}
 
-void iterate(int uppermost, int lowermost) {
-  tmp_grid_at_level = grid_at_level;
-  for (auto &[level, grid] : tmp_grid_at_level) {
-    grid = iterateGrid(level, grid);
+  // stage the levels in a contiguous buffer with an empty level on each side
+  const int n = (int)levels.size();
+  const int padded = (n + LANES - 1) / LANES * LANES + 2;
+  std::vector<uint32_t> buf(padded, 0);
+  std::copy(levels.begin(), levels.end(), buf.begin() + 1);
+
+  int i = 0;
+  for (; i + LANES <= n; i += LANES) {
+    Lanes upper, grid, lower;
+    memcpy(&upper, &buf[i], sizeof(Lanes));
+    memcpy(&grid, &buf[i + 1], sizeof(Lanes));
+    memcpy(&lower, &buf[i + 2], sizeof(Lanes));
+    Lanes next;
+    stepGrid(&upper, &grid, &lower, &next);
+    for (int l = 0; l < LANES; l++) {
+      levels[i + l] = next[l];
+    }
+  }
+  for (; i < n; i++) {
+    stepGrid(&buf[i], &buf[i + 1], &buf[i + 2], &levels[i]);
   }
-  std::swap(tmp_grid_at_level, grid_at_level);
 }
 
 int countBugs() {
   int count = 0;
-  for (auto [level, grid] : grid_at_level) {
+  for (auto grid : levels) {
     count += __builtin_popcount(grid);
   }
   return count;
@@ -171,18 +181,14 @@ int main() {
     x += 1;
   }
 
-  grid_at_level[0] = grid;
-  int uppermost = 0;
-  int lowermost = 0;
-  renderLevels(uppermost, lowermost);
+  levels.push_back(grid);
+  renderLevels();
 
   const int MINUTES = 200;
   for (int i = 1; i <= MINUTES; i++) {
-    grid_at_level[--uppermost] = 0;
-    grid_at_level[++lowermost] = 0;
-    iterate(uppermost, lowermost);
+    iterate();
     // printf("After %d minutes:\n", i);
-    // renderLevels(uppermost, lowermost);
+    // renderLevels();
     // putchar('\n');
   }
 
@@ -1,7 +1,7 @@
 #include <unistd.h>
+#include <bitset>
 #include <cassert>
 #include <cstdio>
-#include <unordered_set>
 
 #include "lib.h"
 
@@ -58,6 +58,43 @@ uint32_t iterateGrid(uint32_t grid) {
   return new_grid;
 }
 
+#define GRID_MASK 0x1ffffffu
+#define FIRST_COL_MASK 0x108421u
+#define LAST_COL_MASK (FIRST_COL_MASK << 4u)
+
+// Same rules as iterateGrid(), but counting the neighbours of all 25 cells
+// at once with bit-sliced adders (counts of 0..3, and overflow for cells
+// that saw 4 neighbours).
+uint32_t iterateGridBitParallel(uint32_t grid) {
+  BitCounter<uint32_t, 2> n;
+  n.add((grid << 5u) & GRID_MASK);
+  n.add(grid >> 5u);
+  n.add((grid << 1u) & ~FIRST_COL_MASK & GRID_MASK);
+  n.add((grid >> 1u) & ~LAST_COL_MASK);
+
+  uint32_t exactly_one = n.equals(1);
+  uint32_t one_or_two = exactly_one | n.equals(2);
+  return ((grid & exactly_one) | (~grid & one_or_two)) & GRID_MASK;
+}
+
+// Checks iterateGridBitParallel() against iterateGrid() once, on the empty
+// and full grids, the input and a few pseudo-random grids.
+void checkBitParallel(uint32_t input) {
+  uint32_t grids[] = {0, GRID_MASK, input};
+  for (uint32_t grid : grids) {
+    assert(iterateGridBitParallel(grid) == iterateGrid(grid));
+  }
+  uint32_t state = input;
+  for (int i = 0; i < 64; i++) {
+    state = state * 1664525u + 1013904223u;
+    uint32_t grid = (state >> 7) & GRID_MASK;
+    assert(iterateGridBitParallel(grid) == iterateGrid(grid));
+  }
+}
+
+// One bit for each of the 2^25 possible grids (4MB).
+std::bitset<1u << 25> seen;
+
 int main() {
   uint32_t grid = 0;
   int y = 0, x = 0;
@@ -75,15 +112,16 @@ int main() {
     x += 1;
   }
 
-  std::unordered_set<uint32_t> seen;
-  seen.insert(grid);
+  checkBitParallel(grid);
+
+  seen.set(grid);
   for (;;) {
-    grid = iterateGrid(grid);
-    if (contains(seen, grid)) {
+    grid = iterateGridBitParallel(grid);
+    if (seen.test(grid)) {
       printf("Found cycle: %d\n", grid);
       return 0;
     }
-    seen.insert(grid);
+    seen.set(grid);
   }
 
   return 0;
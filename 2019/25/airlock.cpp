@@ -1,9 +1,11 @@
+#include <atomic>
 #include <cassert>
 #include <cstdio>
 #include <iostream>  // for getline
 #include <string>
 
 #include "intcode.h"
+#include "lib.h"
 
 struct Game {
   explicit Game(Program program)
@@ -70,7 +72,9 @@ struct Game {
     macro.emplace_back("east");
 
     const std::string output = runMacro(macro, verbose);
-    printf("%s", output.c_str());
+    if (verbose) {
+      printf("%s", output.c_str());
+    }
 
     const char LIGHTER_ALERT[] =
         "Alert! Droids on this ship are lighter than the detected value!";
@@ -129,12 +133,28 @@ struct Game {
     output = runMacro(take_everything, verbose);
     printf("%s", output.c_str());
 
-    // try all combinations until it works
-    uint32_t inventory = 0;
-    for (; inventory < (0x1 << _all_items.size()); inventory++) {
-      if (isCorrectWeight(inventory, verbose)) {
-        return;
-      }
+    // try all combinations, each on its own copy of the droid, and replay
+    // the lowest one that works. Those above the lowest found so far are
+    // skipped; those below still run, so the pick is the same as in order.
+    const int num_inventories = 0x1 << _all_items.size();
+    std::atomic<int> found{num_inventories};
+    parallel_for(
+        0, num_inventories,
+        [&](int inventory) {
+          if (inventory > found.load()) {
+            return;
+          }
+          Game game = *this;
+          if (game.isCorrectWeight(inventory, /* verbose */ false)) {
+            int lowest = found.load();
+            while (inventory < lowest &&
+                   !found.compare_exchange_weak(lowest, inventory)) {
+            }
+          }
+        },
+        /* grain */ 1);
+    if (found < num_inventories && isCorrectWeight(found, verbose)) {
+      return;
     }
 
     std::string command;
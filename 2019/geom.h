@@ -2,6 +2,8 @@
 
 #include <unordered_map>
 
+#include "hash.h"
+
 struct Pt {
   Pt() : x(0), y(0) {}
 
@@ -72,10 +74,7 @@ struct Line {
 namespace std {
 
 template <> struct hash<Pt> {
-  size_t operator()(const Pt &k) const {
-    std::hash<int> hasher;
-    return hasher(k.x) ^ hasher(k.y);
-  }
+  size_t operator()(const Pt &k) const { return hashPoint(k.x, k.y); }
 };
 
 } // namespace std
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <algorithm>
 #include <cassert>
 #include <cstdio>
@@ -5,6 +7,7 @@
 #include <queue>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 enum Opcode {
@@ -24,6 +27,14 @@ using Word = long long;
 using Program = std::vector<Word>;
 using Buffer = std::vector<Word>;
 
+// Sparse memory past the end of the program. Any map with find() and
+// operator[] works: define INTCODE_EXTRA_MEM as FlatMap<Word, Word> (lib.h)
+// before including this header to use a flat table.
+#ifndef INTCODE_EXTRA_MEM
+#define INTCODE_EXTRA_MEM std::unordered_map<Word, Word>
+#endif
+using ExtraMem = INTCODE_EXTRA_MEM;
+
 struct Device {
   bool hasData() const { return !_fifo.empty(); }
 
@@ -407,13 +418,16 @@ struct CPU {
     assert(addr >= 0);
     Word val = 0;
     if (addr >= _mem.size()) {
-      val = _extra_mem[addr];
+      auto it = _extra_mem.find(addr);  // reads don't allocate
+      val = it != _extra_mem.end() ? it->second : 0;
     } else {
       val = _mem[addr];
     }
     return val;
   }
 
+  // The pointer is only valid until the next write to extra memory, as
+  // ExtraMem may move its entries when it grows.
   Word *derefDest(Word addr) {
     assert(addr >= 0);
     Word *val = nullptr;
@@ -422,9 +436,59 @@ struct CPU {
     } else {
       val = &_mem[addr];
     }
+    if (_journaling) {
+      // the caller is about to write to *val
+      _journal.emplace_back(addr, *val);
+    }
     return val;
   }
 
+  // Snapshot/rollback for speculative execution. While a checkpoint is
+  // active, the old value of every memory cell written is journaled, so
+  // rolling back costs O(writes since the checkpoint) instead of copying
+  // the whole machine.
+  struct Checkpoint {
+    int pc;
+    int op;
+    Word bp;
+    enum Status status;
+    Device input;
+    Device output;
+    size_t journal_size;
+  };
+
+  Checkpoint checkpoint() {
+    _journaling = true;
+    return Checkpoint{pc, op, bp, status, _input, _output, _journal.size()};
+  }
+
+  void rollback(const Checkpoint &cp) {
+    while (_journal.size() > cp.journal_size) {
+      auto [addr, old_val] = _journal.back();
+      _journal.pop_back();
+      if (addr >= _mem.size()) {
+        _extra_mem[addr] = old_val;
+      } else {
+        _mem[addr] = old_val;
+      }
+    }
+    _journaling = !_journal.empty();
+
+    pc = cp.pc;
+    op = cp.op;
+    bp = cp.bp;
+    status = cp.status;
+    _input = cp.input;
+    _output = cp.output;
+    clearRegisters();
+  }
+
+  // Keeps the current state and drops all active checkpoints.
+  void discardCheckpoints() {
+    _journaling = false;
+    _journal.clear();
+  }
+
   void pushInput(Word word) { _input.produce(word); }
   void pushInput(const std::string &ascii) { _input.produce(ascii); }
   bool hasInput() const { return _input.hasData(); }
@@ -471,7 +535,10 @@ struct CPU {
   Device _output;
 
   Buffer _mem;
-  std::unordered_map<Word, Word> _extra_mem;
+  ExtraMem _extra_mem;
+
+  bool _journaling = false;
+  std::vector<std::pair<Word, Word>> _journal;  // (addr, old value)
 };
 
 Program runProgramAndGetOutput(Program program, const Program &input) {
@@ -16,6 +16,36 @@ TEST_CASE("Intcode utilities") {
     REQUIRE(parseProgram("1,2") == Program({1, 2}));
     REQUIRE(parseProgram("1,2,3,4,5,6") == Program({1, 2, 3, 4, 5, 6}));
   }
+
+  SECTION("Checkpoint and rollback") {
+    // counts the inputs in mem[100] and echoes them until a 0
+    CPU cpu("3,50,1001,100,1,100,4,50,1005,50,0,99");
+    cpu.pushInput(7);
+    cpu.run();
+    REQUIRE(cpu.consumeOutput() == 7);
+    REQUIRE(cpu.status == PENDING_IN);
+
+    auto cp = cpu.checkpoint();
+    cpu.pushInput(8);
+    cpu.pushInput(0);
+    cpu.run();
+    REQUIRE(cpu.status == HALTED);
+    REQUIRE(cpu.deref(100) == 3);
+    REQUIRE(cpu.deref(1000) == 0);
+    *cpu.derefDest(1000) = 42;  // extra memory is journaled too
+
+    cpu.rollback(cp);
+    REQUIRE(cpu.status == PENDING_IN);
+    REQUIRE(!cpu.hasOutput());
+    REQUIRE(cpu.deref(100) == 1);
+    REQUIRE(cpu.deref(1000) == 0);
+
+    cpu.pushInput(0);
+    cpu.run();
+    REQUIRE(cpu.status == HALTED);
+    REQUIRE(cpu.deref(100) == 2);
+    REQUIRE(cpu.consumeOutput() == 0);
+  }
 }
 
 TEST_CASE("Day 02: 1202 Program Alarm", "[intcode]") {
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Character screen for the visual Intcode days. Frames are drawn into a back
+// buffer and present() only emits the cells that changed since the previous
+// frame (ANSI cursor moves + runs of characters), in a single write(2).
+// Frames are paced to max_fps: present() sleeps until the next frame is due,
+// so animations play at a watchable speed. With skip_frames, frames that
+// come too early are dropped instead, for instrumented runs that only want
+// to see where the run is at.
+struct Terminal {
+  explicit Terminal(int max_fps = 60, bool skip_frames = false)
+      : _skip_frames(skip_frames) {
+    setMaxFps(max_fps);
+  }
+
+  void setMaxFps(int max_fps) {
+    _min_frame_time = max_fps > 0 ? std::chrono::microseconds(1000000 / max_fps)
+                                  : std::chrono::microseconds(0);
+  }
+
+  void setSkipFrames(bool skip_frames) { _skip_frames = skip_frames; }
+
+  // Statistics
+  int frames_presented = 0;
+  int frames_dropped = 0;
+  size_t bytes_written = 0;
+
+  void clear(char c = ' ') {
+    for (auto &row : _back) {
+      std::fill(row.begin(), row.end(), c);
+    }
+  }
+
+  void put(int x, int y, char c) {
+    if (x < 0 || y < 0) {
+      return;
+    }
+    if (y >= (int)_back.size()) {
+      _back.resize(y + 1);
+    }
+    auto &row = _back[y];
+    if (x >= (int)row.size()) {
+      row.resize(x + 1, ' ');
+    }
+    row[x] = c;
+  }
+
+  void print(int x, int y, const std::string &s) {
+    for (int i = 0; i < (int)s.size(); i++) {
+      put(x + i, y, s[i]);
+    }
+  }
+
+  // Emits the difference between the back buffer and what is on screen,
+  // once the frame is due unless `force`. Returns false if the frame was
+  // dropped (only with skip_frames).
+  bool present(bool force = false) {
+    auto now = std::chrono::steady_clock::now();
+    const auto due = _last_frame + _min_frame_time;
+    if (!force && frames_presented > 0 && now < due) {
+      if (_skip_frames) {
+        frames_dropped += 1;
+        return false;
+      }
+      std::this_thread::sleep_until(due);
+      now = due;  // keeps the pace even when the sleep overshoots
+    }
+    _last_frame = now;
+
+    _out.clear();
+    if (frames_presented == 0) {
+      _out += "\x1B[2J";  // clear screen
+    }
+    if (_front.size() < _back.size()) {
+      _front.resize(_back.size());
+    }
+    for (int y = 0; y < (int)_back.size(); y++) {
+      const auto &back = _back[y];
+      auto &front = _front[y];
+      if (front.size() < back.size()) {
+        front.resize(back.size(), '\0');  // unknown, always redrawn
+      }
+      for (int x = 0; x < (int)back.size();) {
+        if (back[x] == front[x]) {
+          x++;
+          continue;
+        }
+        // one cursor move per run of changed cells
+        int end = x;
+        while (end < (int)back.size() && back[end] != front[end]) {
+          end++;
+        }
+        char move[32];
+        snprintf(move, sizeof(move), "\x1B[%d;%dH", y + 1, x + 1);
+        _out += move;
+        _out.append(back, x, end - x);
+        std::copy(back.begin() + x, back.begin() + end, front.begin() + x);
+        x = end;
+      }
+    }
+    char park[32];
+    snprintf(park, sizeof(park), "\x1B[%d;1H", (int)_back.size() + 1);
+    _out += park;
+
+    fflush(stdout);  // keep ordering with stdio output
+    for (size_t done = 0; done < _out.size();) {
+      ssize_t n = write(STDOUT_FILENO, _out.data() + done, _out.size() - done);
+      if (n <= 0) {
+        break;
+      }
+      done += n;
+    }
+    bytes_written += _out.size();
+    frames_presented += 1;
+    return true;
+  }
+
+  void printStats() const {
+    printf("terminal: %d frames presented, %d dropped, %zu bytes written\n",
+           frames_presented, frames_dropped, bytes_written);
+  }
+
+ private:
+  std::vector<std::string> _back;
+  std::vector<std::string> _front;
+  std::string _out;
+  std::chrono::steady_clock::time_point _last_frame;
+  std::chrono::microseconds _min_frame_time;
+  bool _skip_frames;
+};
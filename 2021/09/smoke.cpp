@@ -1,92 +1,66 @@
-#include <array>
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
-#include <queue>
 #include <string>
 #include <vector>
 
-#include "../geom.h"
+#include "../lib.h"  // for BitGrid
 
-using namespace std;
-
-std::vector<std::string> table;
-int visited[256][256];
-
-Pt dirs[4] = {
-    Pt(0, -1),
-    Pt(1, 0),
-    Pt(0, 1),
-    Pt(-1, 0),
-};
-
-int value(Pt p) { return table[p.y][p.x] - '0'; }
-void resetVisited() { memset(visited, 0, sizeof(visited)); }
-bool isVisited(Pt p) { return visited[p.y][p.x]; }
-void markAsVisited(Pt p) { visited[p.y][p.x] = 1; }
-
-int expandBasin(Pt center) {
-  resetVisited();
-
-  queue<Pt> q;
-  q.push(center);
-  int size = 0;
-
-  while (!q.empty()) {
-    const Pt v = q.front();
-    q.pop();
-    size += 1;
-
-    for (Pt dir : dirs) {
-      const Pt w = v + dir;
-      const int value_w = value(w);
-      if (value_w < 9 && value_w > value(v) && !isVisited(w)) {
-        q.push(w);
-        markAsVisited(w);
-      }
-    }
-  }
-
-  return size;
-}
-
-std::vector<int> basins;
+// at_most[d] holds the cells with a height of d or less, so the questions
+// about heights become word-parallel operations on bit grids.
+BitGrid at_most[10];
 
+// Usage: ./a.out < in
 int main() {
+  std::vector<std::string> table;
   char buf[256];
   while (scanf("%255s", buf) == 1) {
     table.emplace_back(buf);
-    // printf("%s\n", table.back().c_str());
   }
 
-  int risk_sum = 0;
   const int w = table[0].size();
   const int h = table.size();
+  for (int d = 0; d < 10; d++) {
+    at_most[d] = BitGrid(w, h);
+  }
   for (int y = 0; y < h; y++) {
     for (int x = 0; x < w; x++) {
-      Pt p(x, y);
-      const int center_val = value(p);
-      bool low_center = true;
-      for (Pt dir : dirs) {
-        Pt neigh = p + dir;
-        if (!neigh.withinBox(w, h)) {
-          continue;
-        }
-        if (value(neigh) <= center_val) {
-          low_center = false;
-          break;
-        }
-      }
-      if (low_center) {
-        risk_sum += center_val + 1;
-        basins.push_back(expandBasin(p));
+      const int value = table[y][x] - '0';
+      assert(value >= 0 && value <= 9);
+      for (int d = value; d < 10; d++) {
+        at_most[d].set(Vec(x, y));
       }
     }
   }
+
+  // A basin is what can be reached from its low point without crossing a 9.
+  std::vector<int> basins;
+  auto expandBasin = [&](Vec low_point) {
+    BitGrid seed(w, h);
+    seed.set(low_point);
+    basins.push_back(seed.floodFill(at_most[8]).count());
+  };
+
+  // Low points of height d: cells of height d none of whose neighbours is
+  // d or less.
+  int risk_sum = 0;
+  for (int d = 0; d < 9; d++) {
+    BitGrid low = at_most[d].step(
+        false, [](uint64_t, const BitCounter<uint64_t, 4> &n) {
+          return n.equals(0);
+        });
+    low &= at_most[d];
+    if (d > 0) {
+      low.andNot(at_most[d - 1]);
+    }
+    risk_sum += (d + 1) * low.count();
+    low.forEach(expandBasin);
+  }
   printf("risk sum: %d\n", risk_sum);
 
   int biggest_basins_product = 1;
   std::sort(basins.begin(), basins.end());
-  for (int i = basins.size() - 3; i < basins.size(); i++) {
+  for (int i = basins.size() - 3; i < (int)basins.size(); i++) {
     biggest_basins_product *= basins[i];
   }
   printf("product: %d\n", biggest_basins_product);
@@ -1,91 +1,95 @@
-#include <algorithm>
 #include <cassert>
 #include <cstdio>
-#include <queue>
-#include <unordered_set>
+#include <string_view>
+#include <vector>
 
-#include "../geom.h"  // for Pt
-#include "../lib.h"   // for contains
+#include "../lib.h"  // for BitGrid
+
+// Energy levels are bit-sliced over bit grids: bit i of the level of the
+// octopus at p is cell p of energy[i]. Between steps every level is 0..9,
+// and a step updates 64 octopuses per word operation.
+#define ENERGY_BITS 4
 
-const int MAX_DIM = 1024;
 int height, width;
-int map[MAX_DIM][MAX_DIM];
+BitGrid energy[ENERGY_BITS];
 
-void init() {
-  height = 0;
-  width = 0;
-  memset(map, 0, sizeof(map));
+int level(Vec p) {
+  int e = 0;
+  for (int i = 0; i < ENERGY_BITS; i++) {
+    e |= energy[i].get(p) << i;
+  }
+  return e;
 }
 
-int &at(int x, int y) { return map[y][x]; }
-int &at(Pt p) { return at(p.x, p.y); }
-
 void dump(int step) {
   printf("After step %d:\n", step);
   for (int y = 0; y < height; y++) {
     for (int x = 0; x < width; x++) {
-      printf("%d", at(Pt(x, y)));
+      printf("%d", level(Vec(x, y)));
     }
     putchar('\n');
   }
   putchar('\n');
 }
 
+// Adds the bit-sliced counts to the energy levels, and returns the
+// octopuses that reach 10 or more. One that has not flashed yet is at most
+// 9 and gains at most 8, so the carry out of the top bit stands for 16.
+BitGrid addEnergy(const BitGrid *counts) {
+  BitGrid ready(width, height);
+  for (size_t k = 0; k < ready.size(); k++) {
+    uint64_t carry = 0;
+    uint64_t e[ENERGY_BITS];
+    for (int i = 0; i < ENERGY_BITS; i++) {
+      uint64_t a = energy[i].data()[k];
+      uint64_t b = counts[i].data()[k];
+      e[i] = a ^ b ^ carry;
+      carry = (a & b) | (carry & (a ^ b));
+      energy[i].data()[k] = e[i];
+    }
+    // 10 is 0b1010
+    ready.data()[k] = carry | (e[3] & (e[2] | e[1]));
+  }
+  return ready;
+}
+
 void simulate(int num_steps) {
   bool simult_flashed_before = false;
   long long num_flashes = 0;
 
-  std::unordered_set<Pt> flashed;
-  std::queue<Pt> q;
+  // a count of 1 everywhere
+  BitGrid one[ENERGY_BITS];
+  for (int i = 0; i < ENERGY_BITS; i++) {
+    one[i] = BitGrid(width, height);
+  }
+  one[0].fill(true);
 
   int step = 0;
   // dump(step);
   for (step = 1;; step++) {
-    // re-use structures' buffers
-    flashed.clear();
-    assert(q.empty());
-
-    for (int y = 0; y < height; y++) {
-      for (int x = 0; x < width; x++) {
-        Pt p(x, y);
-        if (++at(p) > 9) {    // increase energy for all
-          flashed.insert(p);  // flash the ones with enough energy
-          q.push(p);          // enqueue for energy sharing
-        }
-      }
-    }
-
-    // share the energy
-    while (!q.empty()) {
-      const Pt v = q.front();
-      q.pop();
-
-      // for all neighbors w: give energy to them
-      for (int dy = -1; dy <= 1; dy++) {
-        for (int dx = -1; dx <= 1; dx++) {
-          const Pt w = v + Pt(dx, dy);
-          if (w == v || !w.withinBox(width, height)) continue;
-
-          // increase energy for neighbors that haven't been flashed
-          if (at(w) >= 9 && !contains(flashed, w)) {
-            flashed.insert(w);  // flash them
-            q.push(w);          // push for energy sharing
-          } else {
-            at(w) += 1;
-          }
-        }
-      }
+    // increase energy for all, and flash the ones with enough energy
+    BitGrid flashing = addEnergy(one);
+    BitGrid flashed(width, height);
+
+    // share the energy of each wave of flashes with the neighbours, which
+    // may flash in turn
+    while (flashing.any()) {
+      flashed |= flashing;
+      BitGrid counts[ENERGY_BITS];
+      flashing.countNeighbours(true, counts);
+      flashing = addEnergy(counts);
+      flashing.andNot(flashed);
     }
 
     // clear the flashed
-    for (auto p : flashed) {
-      at(p) = 0;
+    for (BitGrid &plane : energy) {
+      plane.andNot(flashed);
     }
     // count the number of flashes so far
-    num_flashes += flashed.size();
+    num_flashes += flashed.count();
     // dump(step);
 
-    const bool simult_flashed = flashed.size() == width * height;
+    const bool simult_flashed = flashed.count() == width * height;
     if (simult_flashed && !simult_flashed_before) {
       printf("all flashed simultaneosuly at step %d\n", step);
       if (step >= num_steps) break;
@@ -99,25 +103,33 @@ void simulate(int num_steps) {
   }
 }
 
+// Usage: ./a.out < in
 int main() {
-  init();
-
-  int y = 0;
-  int x = 0;
-  for (;;) {
-    char c = getchar();
-    if (c == '\n' || c == EOF) {
-      width = std::max(x, width);
-      y += 1;
-      x = 0;
-      if (c == EOF) break;
-    } else {
-      at(x, y) = c - '0';
-      x += 1;
+  Input input;
+  std::vector<std::string_view> rows;
+  for (std::string_view line : Lines(input.text())) {
+    if (!line.empty()) {
+      rows.push_back(line);
+    }
+  }
+  height = rows.size();
+  width = rows.empty() ? 0 : rows[0].size();
+
+  for (int i = 0; i < ENERGY_BITS; i++) {
+    energy[i] = BitGrid(width, height);
+  }
+  for (int y = 0; y < height; y++) {
+    assert((int)rows[y].size() == width);
+    for (int x = 0; x < width; x++) {
+      int e = rows[y][x] - '0';
+      assert(e >= 0 && e <= 9);
+      for (int i = 0; i < ENERGY_BITS; i++) {
+        if ((e >> i) & 1) {
+          energy[i].set(Vec(x, y));
+        }
+      }
     }
   }
-  height = y - 1;
-  assert(height <= MAX_DIM && width <= MAX_DIM);
 
   simulate(100);
   return 0;
@@ -1,11 +1,10 @@
+#include <cassert>
 #include <cstdio>
-#include <queue>
-#include <unordered_set>
+#include <cstring>
 
 #include "../geom.h"
 #include "../lib.h"
-
-constexpr int INF = std::numeric_limits<int>::max();
+#include "../search.h"
 
 constexpr int MAXD = 100;
 int grid[MAXD * 5][MAXD * 5];
@@ -41,18 +40,6 @@ void expand() {
   n *= 5;
 }
 
-class RiskPos {
- public:
-  RiskPos(int risk, Pt pos) noexcept : risk(risk), pos(pos) {}
-
-  bool operator<(const RiskPos &other) const {
-    return (risk > other.risk) || (risk == other.risk && pos < other.pos);
-  }
-
-  int risk;
-  Pt pos;
-};
-
 int riskOfLeastRiskyPath() {
   const Pt dirs[4] = {
       Pt(0, -1),
@@ -61,51 +48,27 @@ int riskOfLeastRiskyPath() {
       Pt(-1, 0),
   };
 
-  std::priority_queue<RiskPos> pq;
-  std::unordered_map<Pt, Pt> parent;
-  std::unordered_map<Pt, int> min_risk;
-
-  auto minRisk = [&min_risk](Pt pt) -> int {
-    return lookupOr(min_risk, pt, INF);
-  };
-
-  // Init
-  Pt origin(0, 0);
-  parent[origin] = origin;
-  for (int y = 0; y < m; y++) {
-    for (int x = 0; x < n; x++) {
-      Pt p(x, y);
-      const int risk = (p == origin) ? grid[origin.y][origin.x] : INF;
-      min_risk[p] = risk;
-      pq.push(RiskPos(risk, origin));
-    }
-  }
-
-  // Minimize all paths from source
-  while (!pq.empty()) {
-    const RiskPos v = pq.top();
-    pq.pop();
-    const int min_risk_v = minRisk(v.pos);
-    for (Pt dir : dirs) {
-      const Pt w = v.pos + dir;
-      if (!w.withinBox(n, m)) continue;
-
-      int min_risk_w = minRisk(w);
-      assert(min_risk_w > 0);
-      if (min_risk_v + grid[w.y][w.x] < min_risk_w) {
-        min_risk_w = min_risk_v + grid[w.y][w.x];
-        min_risk[w] = min_risk_w;
-        pq.push(RiskPos(min_risk_w, w));
-        assert(w != v.pos);
-        parent[w] = v.pos;
-      }
-    }
-  }
+  // Least risk found so far per position, with the parents for the path
+  auto min_risk = denseStates<Pt, int>(
+      m * n, [](Pt p) { return (size_t)p.y * n + p.x; }, true);
+  // risks are 1..9, so Dial's buckets hold every risk within reach
+  BucketQueue<Pt, int> queue(9);
 
+  const Pt origin(0, 0);
   const Pt dest(n - 1, m - 1);
+  dijkstra(
+      &min_risk, &queue, origin,
+      [&dirs](Pt v, auto emit) {
+        for (Pt dir : dirs) {
+          const Pt w = v + dir;
+          if (w.withinBox(n, m)) emit(w, grid[w.y][w.x]);
+        }
+      },
+      [&dest](Pt v) { return v == dest; });
+
   /*
   memset(grid_path, -1, sizeof(grid_path));
-  for (Pt p = dest; p != Pt(0, 0); p = parent[p]) {
+  for (Pt p : path(min_risk, dest)) {
     grid_path[p.y][p.x] = grid[p.y][p.x];
   }
   for (int y = 0; y < m; y++) {
@@ -122,7 +85,7 @@ int riskOfLeastRiskyPath() {
   putchar('\n');
   */
 
-  return minRisk(dest) - grid[origin.y][origin.x];
+  return min_risk.cost(dest);
 }
 
 int main() {
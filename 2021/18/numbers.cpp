@@ -1,25 +1,30 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdio>
-#include <memory>
-#include <utility>
 #include <vector>
 
+#include "../lib.h"
+
+class Pair;
+
+// Every Pair comes from a pool: explode() and split() swap nodes out all the
+// time, and their slots are reused right away.
+using PairPool = ObjectPool<Pair>;
+
 class Pair {
  public:
-  std::unique_ptr<Pair> left;
-  std::unique_ptr<Pair> right;
+  Pair* left = nullptr;
+  Pair* right = nullptr;
   int value;
 
   Pair* parent = nullptr;
 
-  Pair(std::unique_ptr<Pair>&& l, std::unique_ptr<Pair>&& r)
-      : left(std::move(l)), right(std::move(r)), value(0) {
+  Pair(Pair* l, Pair* r) : left(l), right(r), value(0) {
     left->parent = this;
     right->parent = this;
   }
 
-  explicit Pair(int value) : left(nullptr), right(nullptr), value(value) {}
+  explicit Pair(int value) : value(value) {}
 
   bool isValue() const { return !left; }
 
@@ -27,36 +32,36 @@ class Pair {
     return isValue() ? value : 3 * left->magnitude() + 2 * right->magnitude();
   }
 
-  bool reduce() {
+  bool reduce(PairPool* pool) {
     bool reduced = false;
-    while (explode() || split()) reduced = true;
+    while (explode(pool) || split(pool)) reduced = true;
     return reduced;
   }
 
-  bool split() {
-    return (left && left->split()) || (right && right->split()) ||
-           (value > 9 && parent->split(this));
+  bool split(PairPool* pool) {
+    return (left && left->split(pool)) || (right && right->split(pool)) ||
+           (value > 9 && parent->split(this, pool));
   }
 
-  bool split(const Pair* referential) {
+  bool split(Pair* referential, PairPool* pool) {
     printf("split: ");
     referential->dump();
 
     const int v = referential->value;
-    auto p = std::make_unique<Pair>(std::make_unique<Pair>(v / 2),
-                                    std::make_unique<Pair>(v - (v / 2)));
+    Pair* p = pool->make(pool->make(v / 2), pool->make(v - (v / 2)));
     p->parent = this;
-    if (referential == left.get()) {
-      left = std::move(p);
+    if (referential == left) {
+      left = p;
     } else {
-      right = std::move(p);
+      right = p;
     }
+    pool->destroy(referential);
     return true;
   }
 
-  bool explode() { return explode(0); }
+  bool explode(PairPool* pool) { return explode(0, pool); }
 
-  bool explode(int level) {
+  bool explode(int level, PairPool* pool) {
     if (level == 4 && left) {
       printf("explode: ");
       dump();
@@ -65,24 +70,24 @@ class Pair {
       assert(parent);
       parent->sendLeft(this, left->value);
       parent->sendRight(this, right->value);
-      parent->clear(this);
+      parent->clear(this, pool);  // destroys this
       return true;
     }
-    return (left && left->explode(level + 1)) ||
-           (right && right->explode(level + 1));
+    return (left && left->explode(level + 1, pool)) ||
+           (right && right->explode(level + 1, pool));
   }
 
   void sendLeft(const Pair* referential, int value) {
-    if (referential == right.get()) {
+    if (referential == right) {
       left->sendRighmost(value);
     } else if (parent) {
-      assert(left.get() == referential);
+      assert(left == referential);
       parent->sendLeft(this, value);
     }
   }
 
   void sendRight(const Pair* referential, int value) {
-    if (referential == left.get()) {
+    if (referential == left) {
       right->sendLeftmost(value);
     } else if (parent) {
       parent->sendRight(this, value);
@@ -105,15 +110,25 @@ class Pair {
     }
   }
 
-  void clear(const Pair* referential) {
-    auto zero = std::make_unique<Pair>(0);
+  void clear(Pair* referential, PairPool* pool) {
+    Pair* zero = pool->make(0);
     zero->parent = this;
-    if (left.get() == referential) {
-      left = std::move(zero);
+    if (left == referential) {
+      left = zero;
     } else {
-      assert(referential == right.get());
-      right = std::move(zero);
+      assert(referential == right);
+      right = zero;
+    }
+    referential->destroy(pool);
+  }
+
+  // Gives this pair and everything under it back to the pool.
+  void destroy(PairPool* pool) {
+    if (left) {
+      left->destroy(pool);
+      right->destroy(pool);
     }
+    pool->destroy(this);
   }
 
   void dump() const {
@@ -134,46 +149,45 @@ class Pair {
     }
   }
 
-  std::unique_ptr<Pair> clone() {
+  Pair* clone(PairPool* pool) const {
     if (isValue()) {
-      return std::make_unique<Pair>(value);
+      return pool->make(value);
     }
-    auto ret = std::make_unique<Pair>(left->clone(), right->clone());
-    return ret;
+    return pool->make(left->clone(pool), right->clone(pool));
   }
 };
 
-std::unique_ptr<Pair> sum(std::unique_ptr<Pair>&& a,
-                          std::unique_ptr<Pair>&& b) {
+// Takes a and b over.
+Pair* sum(Pair* a, Pair* b, PairPool* pool) {
   a->dump(nullptr);
   printf(" +\n");
   b->dump(nullptr);
   printf(" =\n");
-  auto s = std::make_unique<Pair>(std::move(a), std::move(b));
-  s->reduce();
+  Pair* s = pool->make(a, b);
+  s->reduce(pool);
   s->dump();
   return s;
 }
 
-std::unique_ptr<Pair> parsePair() {
+Pair* parsePair(PairPool* pool) {
   char c = getchar();
   if (c == '[') {
-    auto left = parsePair();
+    Pair* left = parsePair(pool);
     c = getchar();
     assert(c == ',');
-    auto right = parsePair();
+    Pair* right = parsePair(pool);
     c = getchar();
     assert(c == ']');
-    auto pair = std::make_unique<Pair>(std::move(left), std::move(right));
-    return pair;
+    return pool->make(left, right);
   }
 
   assert(c >= '0' && c <= '9');
-  return std::make_unique<Pair>(c - '0');
+  return pool->make(c - '0');
 }
 
 int main() {
-  std::vector<std::unique_ptr<Pair>> numbers;
+  PairPool pool;
+  std::vector<Pair*> numbers;
 
   for (;;) {
     char c = getchar();
@@ -182,14 +196,14 @@ int main() {
     }
     ungetc(c, stdin);
 
-    auto p = parsePair();
+    Pair* p = parsePair(&pool);
     c = getchar();
     if (c == '\n') {
       p->dump();
-      if (p->reduce()) {
+      if (p->reduce(&pool)) {
         p->dump();
       }
-      numbers.push_back(std::move(p));
+      numbers.push_back(p);
       putchar('\n');
       continue;
     }
@@ -198,9 +212,9 @@ int main() {
     }
   }
 
-  auto s = numbers[0]->clone();
+  Pair* s = numbers[0]->clone(&pool);
   for (int i = 1; i < numbers.size(); i++) {
-    s = sum(std::move(s), numbers[i]->clone());
+    s = sum(s, numbers[i]->clone(&pool), &pool);
     putchar('\n');
   }
   printf("\nsum: ");
@@ -208,12 +222,19 @@ int main() {
 
   printf("magnitude: %lld\n", s->magnitude());
 
+  // Each of these sums is thrown away whole: its nodes come from a scratch
+  // arena that is reset in one go, along with the pool on top of it.
+  Arena scratch;
+  PairPool scratch_pool(&scratch);
   long long max_magnitude = 0;
   for (int i = 0; i < numbers.size(); i++) {
     for (int j = 0; j < numbers.size(); j++) {
       if (i == j) continue;
-      auto s = sum(numbers[i]->clone(), numbers[j]->clone());
+      Pair* s = sum(numbers[i]->clone(&scratch_pool),
+                    numbers[j]->clone(&scratch_pool), &scratch_pool);
       max_magnitude = std::max(max_magnitude, s->magnitude());
+      scratch.reset();
+      scratch_pool.reset();
     }
   }
   printf("maximum magnitude of pair sum: %lld\n", max_magnitude);
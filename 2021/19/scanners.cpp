@@ -194,16 +194,33 @@ void fixateAllScanners() {
     const int s = q.front();
     q.pop();
 
+    // try s against every scanner not fixated yet in parallel, then fixate
+    // the ones that align in order
+    std::vector<int> candidates;
     for (int t = 0; t < scanners.size(); t++) {
       if (scanners[t].fixated()) continue;
       assert(t != s);
-
+      candidates.push_back(t);
+    }
+    struct Alignment {
+      bool found = false;
       Pos t_pos;
-      int x;
-      if (scanners[s].canIntersect(scanners[t], t_pos, x)) {
-        printf("align %d %d (xform=%d)\n", s, t, x);
-        t_pos.dump();
-        scanners[t].fixate(x, t_pos);
+      int x = 0;
+    };
+    std::vector<Alignment> alignments(candidates.size());
+    parallel_for(0, (int)candidates.size(), [&](int i) {
+      Alignment& a = alignments[i];
+      a.found =
+          scanners[s].canIntersect(scanners[candidates[i]], a.t_pos, a.x);
+    }, /* grain */ 1);
+
+    for (int i = 0; i < candidates.size(); i++) {
+      const int t = candidates[i];
+      const Alignment& a = alignments[i];
+      if (a.found) {
+        printf("align %d %d (xform=%d)\n", s, t, a.x);
+        a.t_pos.dump();
+        scanners[t].fixate(a.x, a.t_pos);
         q.push(t);
       }
     }
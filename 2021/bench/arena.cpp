@@ -0,0 +1,232 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "../lib.h"
+
+// Allocation-heavy workloads with the default allocator, ObjectPool and
+// Arena:
+//  - trees like Day 18's snailfish numbers: built, then leaves split in two
+//    and pairs of leaves merged back at random, then dropped;
+//  - memo tables filled for a round and then thrown away.
+// Allocations are counted by replacing operator new.
+//
+// Usage: make bench/arena && ./a.out [rounds]
+
+static long long allocations = 0;
+
+void *operator new(size_t size) {
+  allocations++;
+  if (void *p = malloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+template <typename F>
+void bench(const char *name, int ops, F f) {
+  long long allocations_before = allocations;
+  auto start = std::chrono::steady_clock::now();
+  long long checksum = f();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  printf("  %-34s %8.1f ns/op %8.3f allocs/op   (%lld)\n", name,
+         elapsed.count() / ops * 1e9,
+         (double)(allocations - allocations_before) / ops, checksum);
+}
+
+// Trees
+
+#define TREE_DEPTH 6
+#define TREE_EDITS 2000
+
+struct UniqueNode {
+  std::unique_ptr<UniqueNode> left, right;
+  int value = 0;
+};
+
+struct RawNode {
+  RawNode *left = nullptr, *right = nullptr;
+  int value = 0;
+};
+
+// The same random edits on any node type. make() returns a new leaf,
+// drop(node) frees a leaf; both are no-ops for unique_ptr nodes, which
+// own their children.
+template <typename Node, typename Ptr, typename Make, typename Drop>
+long long editTree(Ptr &root, std::mt19937 &rng, Make make, Drop drop) {
+  long long checksum = 0;
+  for (int edit = 0; edit < TREE_EDITS; edit++) {
+    Ptr *p = &root;
+    for (;;) {
+      Node *n = &**p;
+      if (!n->left) {
+        // split a leaf
+        n->left = make(n->value / 2);
+        n->right = make(n->value - n->value / 2);
+        break;
+      }
+      if (!n->left->left && !n->right->left && rng() % 2) {
+        // merge a pair of leaves
+        n->value = n->left->value + n->right->value + 1;
+        drop(n->left);
+        drop(n->right);
+        n->left = nullptr;
+        n->right = nullptr;
+        checksum += n->value;
+        break;
+      }
+      p = rng() % 2 ? &n->left : &n->right;
+    }
+  }
+  return checksum;
+}
+
+template <typename Ptr, typename Make>
+Ptr buildTree(int depth, int value, Make make) {
+  Ptr n = make(value);
+  if (depth > 0) {
+    n->left = buildTree<Ptr>(depth - 1, value * 2, make);
+    n->right = buildTree<Ptr>(depth - 1, value * 2 + 1, make);
+  }
+  return n;
+}
+
+void destroyTree(RawNode *n, ObjectPool<RawNode> *pool) {
+  if (n->left) {
+    destroyTree(n->left, pool);
+    destroyTree(n->right, pool);
+  }
+  pool->destroy(n);
+}
+
+void benchTrees(int rounds) {
+  const int ops = rounds * ((2 << TREE_DEPTH) - 1 + TREE_EDITS);
+  printf("Trees: %d rounds of a depth %d tree and %d edits\n", rounds,
+         TREE_DEPTH, TREE_EDITS);
+
+  bench("std::make_unique", ops, [&] {
+    std::mt19937 rng(18);
+    long long checksum = 0;
+    auto make = [](int v) {
+      auto n = std::make_unique<UniqueNode>();
+      n->value = v;
+      return n;
+    };
+    for (int r = 0; r < rounds; r++) {
+      auto root = buildTree<std::unique_ptr<UniqueNode>>(TREE_DEPTH, 1, make);
+      checksum += editTree<UniqueNode>(root, rng, make,
+                                       [](std::unique_ptr<UniqueNode> &) {});
+    }
+    return checksum;
+  });
+
+  bench("ObjectPool", ops, [&] {
+    std::mt19937 rng(18);
+    long long checksum = 0;
+    ObjectPool<RawNode> pool;
+    auto make = [&pool](int v) {
+      RawNode *n = pool.make();
+      n->value = v;
+      return n;
+    };
+    for (int r = 0; r < rounds; r++) {
+      RawNode *root = buildTree<RawNode *>(TREE_DEPTH, 1, make);
+      checksum += editTree<RawNode>(root, rng, make,
+                                    [&pool](RawNode *n) { pool.destroy(n); });
+      destroyTree(root, &pool);
+    }
+    return checksum;
+  });
+
+  bench("ObjectPool, Arena reset per round", ops, [&] {
+    std::mt19937 rng(18);
+    long long checksum = 0;
+    Arena arena;
+    for (int r = 0; r < rounds; r++) {
+      ObjectPool<RawNode> pool(&arena);
+      auto make = [&pool](int v) {
+        RawNode *n = pool.make();
+        n->value = v;
+        return n;
+      };
+      RawNode *root = buildTree<RawNode *>(TREE_DEPTH, 1, make);
+      checksum += editTree<RawNode>(root, rng, make,
+                                    [&pool](RawNode *n) { pool.destroy(n); });
+      arena.reset();
+    }
+    return checksum;
+  });
+  printf("\n");
+}
+
+// Memo tables
+
+#define MEMO_KEYS 20000
+
+template <typename Map>
+long long fillMemo(Map &memo, std::mt19937_64 &rng) {
+  long long checksum = 0;
+  for (int i = 0; i < MEMO_KEYS; i++) {
+    uint64_t key = rng() % (MEMO_KEYS * 4);
+    auto [it, inserted] = memo.try_emplace(key, (long long)i);
+    checksum += it->second;
+  }
+  return checksum;
+}
+
+void benchMemo(int rounds) {
+  const int ops = rounds * MEMO_KEYS;
+  printf("Memo tables: %d rounds of %d inserts\n", rounds, MEMO_KEYS);
+
+  bench("std::unordered_map", ops, [&] {
+    std::mt19937_64 rng(21);
+    long long checksum = 0;
+    for (int r = 0; r < rounds; r++) {
+      std::unordered_map<uint64_t, long long> memo;
+      checksum += fillMemo(memo, rng);
+    }
+    return checksum;
+  });
+
+  bench("pmr::unordered_map, Arena", ops, [&] {
+    std::mt19937_64 rng(21);
+    long long checksum = 0;
+    Arena arena;
+    for (int r = 0; r < rounds; r++) {
+      {
+        std::pmr::unordered_map<uint64_t, long long> memo(&arena);
+        checksum += fillMemo(memo, rng);
+      }
+      arena.reset();
+    }
+    return checksum;
+  });
+
+  bench("pmr::unordered_map, monotonic", ops, [&] {
+    std::mt19937_64 rng(21);
+    long long checksum = 0;
+    for (int r = 0; r < rounds; r++) {
+      std::pmr::monotonic_buffer_resource resource;
+      std::pmr::unordered_map<uint64_t, long long> memo(&resource);
+      checksum += fillMemo(memo, rng);
+    }
+    return checksum;
+  });
+  printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+  const int rounds = argc > 1 ? atoi(argv[1]) : 200;
+  benchTrees(rounds);
+  benchMemo(rounds);
+  return 0;
+}
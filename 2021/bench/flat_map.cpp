@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../lib.h"
+
+// Microbenchmark of FlatMap against std::unordered_map on the key types the
+// solutions use.
+//
+// Usage: make bench/flat_map && ./a.out [num_keys]
+
+template <typename F>
+double timeIt(F f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+// ns per operation for: insert all keys, look up all (hits), look up keys
+// that are absent (misses), erase all.
+template <typename Map, typename Key>
+void bench(const char *name, const std::vector<Key> &keys,
+           const std::vector<Key> &absent) {
+  const double n = keys.size();
+  long long checksum = 0;
+  Map m;
+
+  double insert = timeIt([&] {
+    for (size_t i = 0; i < keys.size(); i++) {
+      m[keys[i]] = (int)i;
+    }
+  });
+  double hit = timeIt([&] {
+    for (auto &k : keys) {
+      checksum += *lookup(m, k);
+    }
+  });
+  double miss = timeIt([&] {
+    for (auto &k : absent) {
+      checksum += contains(m, k);
+    }
+  });
+  double erase = timeIt([&] {
+    for (auto &k : keys) {
+      checksum += m.erase(k);
+    }
+  });
+
+  printf("%-28s %8.1f %8.1f %8.1f %8.1f   (%lld)\n", name, insert / n * 1e9,
+         hit / n * 1e9, miss / n * 1e9, erase / n * 1e9, checksum);
+}
+
+template <typename Key>
+void benchBoth(const char *title, const std::vector<Key> &keys,
+               const std::vector<Key> &absent) {
+  printf("\n%s, %zu keys\n", title, keys.size());
+  printf("%-28s %8s %8s %8s %8s\n", "ns/op", "insert", "hit", "miss",
+         "erase");
+  bench<std::unordered_map<Key, int>>("std::unordered_map", keys, absent);
+  bench<FlatMap<Key, int>>("FlatMap", keys, absent);
+}
+
+int main(int argc, char *argv[]) {
+  const int n = argc > 1 ? atoi(argv[1]) : 1000000;
+  std::mt19937 rng(2021);
+
+  // Grid cells in a square around the origin, in random order: the keys of
+  // a flood fill or a map of a puzzle input.
+  std::vector<Vec> cells;
+  std::vector<Vec> outside;
+  int side = 1;
+  while (side * side < n) {
+    side++;
+  }
+  for (int y = 0; y < side; y++) {
+    for (int x = 0; x < side; x++) {
+      if ((int)cells.size() < n) {
+        cells.emplace_back(x - side / 2, y - side / 2);
+        outside.emplace_back(x + side, y - side / 2);
+      }
+    }
+  }
+  std::shuffle(cells.begin(), cells.end(), rng);
+  benchBoth("Vec grid cells", cells, outside);
+
+  // Random pairs, as in memo tables keyed by two small counters.
+  std::vector<std::pair<int, int>> pairs;
+  std::vector<std::pair<int, int>> other_pairs;
+  std::uniform_int_distribution<int> coord(-1000000, 1000000);
+  for (int i = 0; i < n; i++) {
+    pairs.emplace_back(coord(rng), coord(rng));
+    other_pairs.emplace_back(coord(rng), coord(rng));
+  }
+  std::sort(pairs.begin(), pairs.end());
+  pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+  std::shuffle(pairs.begin(), pairs.end(), rng);
+  benchBoth("Random pairs", pairs, other_pairs);
+
+  return 0;
+}
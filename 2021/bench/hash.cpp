@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "../lib.h"
+
+// Collisions and throughput of point hashes on the kinds of key sets the
+// grid puzzles build: the previous hash(x) ^ hash(y) of Pt and hash_combine
+// of Vec, against the packed 64-bit key with the fmix64 finalizer that both
+// use now.
+//
+// Usage: make bench/hash && ./a.out
+
+struct XorHash {
+  size_t operator()(const Vec &v) const {
+    std::hash<int> hasher;
+    return hasher(v.x) ^ hasher(v.y);
+  }
+};
+
+struct CombineHash {
+  size_t operator()(const Vec &v) const {
+    size_t h = 0;
+    hash_combine(h, v.x);
+    hash_combine(h, v.y);
+    return h;
+  }
+};
+
+struct PackedHash {
+  size_t operator()(const Vec &v) const { return hashPoint(v.x, v.y); }
+};
+
+template <typename F>
+double timeIt(F f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+// distinct: fraction of keys with a unique hash value.
+// chain: average number of keys in the bucket of a key in an
+//   std::unordered_set (1.0 + load factor / 2 or so is ideal).
+// ns/hash, then ns per insert + lookup for std::unordered_set and FlatSet.
+template <typename Hash>
+void bench(const char *name, const std::vector<Vec> &keys) {
+  const double n = keys.size();
+
+  std::vector<size_t> hashes;
+  hashes.reserve(keys.size());
+  double hash_time = timeIt([&] {
+    for (auto &k : keys) {
+      hashes.push_back(Hash()(k));
+    }
+  });
+  std::sort(hashes.begin(), hashes.end());
+  size_t unique = 0;
+  for (size_t i = 0; i < hashes.size(); i++) {
+    bool dup = (i > 0 && hashes[i] == hashes[i - 1]) ||
+               (i + 1 < hashes.size() && hashes[i] == hashes[i + 1]);
+    unique += !dup;
+  }
+
+  std::unordered_set<Vec, Hash> set;
+  long long found = 0;
+  double std_time = timeIt([&] {
+    for (auto &k : keys) {
+      set.insert(k);
+    }
+    for (auto &k : keys) {
+      found += contains(set, k);
+    }
+  });
+  double chain = 0;
+  for (size_t b = 0; b < set.bucket_count(); b++) {
+    double size = set.bucket_size(b);
+    chain += size * size;
+  }
+  chain /= n;
+
+  FlatSet<Vec, Hash> flat;
+  double flat_time = timeIt([&] {
+    for (auto &k : keys) {
+      flat.insert(k);
+    }
+    for (auto &k : keys) {
+      found += contains(flat, k);
+    }
+  });
+  assert(found == 2 * (long long)keys.size());
+
+  printf("  %-8s %9.4f %9.2f %9.2f %10.1f %10.1f\n", name, unique / n, chain,
+         hash_time / n * 1e9, std_time / n * 1e9, flat_time / n * 1e9);
+}
+
+void benchAll(const char *title, std::vector<Vec> keys) {
+  std::sort(keys.begin(), keys.end(), [](Vec a, Vec b) {
+    return a.x < b.x || (a.x == b.x && a.y < b.y);
+  });
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(1));
+
+  printf("%s, %zu keys\n", title, keys.size());
+  printf("  %-8s %9s %9s %9s %10s %10s\n", "hash", "distinct", "chain",
+         "ns/hash", "std ns/op", "flat ns/op");
+  bench<XorHash>("xor", keys);
+  bench<CombineHash>("combine", keys);
+  bench<PackedHash>("packed", keys);
+  printf("\n");
+}
+
+int main() {
+  std::mt19937 rng(2021);
+
+  // Day 15: every cell of the 5x expanded cave.
+  std::vector<Vec> cave;
+  for (int y = 0; y < 500; y++) {
+    for (int x = 0; x < 500; x++) {
+      cave.emplace_back(x, y);
+    }
+  }
+  benchAll("Dense 500x500 grid", cave);
+
+  // Day 13: sparse dots on a transparent sheet.
+  std::vector<Vec> dots;
+  for (int i = 0; i < 100000; i++) {
+    dots.emplace_back(rng() % 1311, rng() % 895);
+  }
+  benchAll("Sparse dots in 1311x895", dots);
+
+  // Day 5: points covered by horizontal, vertical and diagonal vents.
+  std::vector<Vec> vents;
+  for (int i = 0; i < 500; i++) {
+    Vec a(rng() % 1000, rng() % 1000);
+    Vec d[] = {Vec(1, 0), Vec(0, 1), Vec(1, 1), Vec(1, -1)};
+    Vec step = d[rng() % 4];
+    int len = rng() % 500;
+    for (int j = 0; j < len; j++, a += step) {
+      vents.push_back(a);
+    }
+  }
+  benchAll("Vent lines in 1000x1000", vents);
+
+  // Flood fill around the origin, negative coordinates included.
+  std::vector<Vec> flood;
+  for (int y = -300; y < 300; y++) {
+    for (int x = -300; x < 300; x++) {
+      if (x * x + y * y < 300 * 300) {
+        flood.emplace_back(x, y);
+      }
+    }
+  }
+  benchAll("Disc of radius 300 around the origin", flood);
+
+  return 0;
+}
@@ -0,0 +1,152 @@
+#include <chrono>
+#include <cstdio>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../lib.h"
+
+// Splitting line-heavy inputs: the old split() that built each piece with
+// `cur += c`, split() as it is now (a wrapper over split_view), and
+// split_view on its own. Allocations are counted by replacing operator new.
+//
+// Usage: make bench/split && ./a.out [num_lines]
+
+static long long allocations = 0;
+
+void *operator new(size_t size) {
+  allocations++;
+  if (void *p = malloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+std::vector<std::string> oldSplit(const std::string &s, char delim) {
+  std::vector<std::string> pieces;
+
+  std::string cur;
+  for (char c : s) {
+    if (c == delim) {
+      if (!cur.empty()) {
+        pieces.emplace_back(std::move(cur));
+      }
+    } else {
+      cur += c;
+    }
+  }
+  if (!cur.empty()) {
+    pieces.emplace_back(std::move(cur));
+  }
+
+  return pieces;
+}
+
+template <typename F>
+void bench(const char *name, const std::vector<std::string> &lines, F f) {
+  long long checksum = 0;
+  long long allocations_before = allocations;
+  auto start = std::chrono::steady_clock::now();
+  for (const std::string &line : lines) {
+    checksum += f(line);
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  printf("  %-24s %8.1f ns/line %8.2f allocs/line   (%lld)\n", name,
+         elapsed.count() / lines.size() * 1e9,
+         (double)(allocations - allocations_before) / lines.size(), checksum);
+}
+
+int main(int argc, char *argv[]) {
+  const int n = argc > 1 ? atoi(argv[1]) : 1000000;
+  std::mt19937 rng(2021);
+
+  // Day 5: "x1,y1 -> x2,y2", split on ' ' and then on ','.
+  std::vector<std::string> vents;
+  for (int i = 0; i < n; i++) {
+    vents.push_back(std::to_string(rng() % 1000) + "," +
+                    std::to_string(rng() % 1000) + " -> " +
+                    std::to_string(rng() % 1000) + "," +
+                    std::to_string(rng() % 1000));
+  }
+  printf("Vent lines, %d lines\n", n);
+  bench("old split", vents, [](const std::string &line) {
+    size_t sum = 0;
+    for (const std::string &half : oldSplit(line, ' ')) {
+      for (const std::string &coord : oldSplit(half, ',')) {
+        sum += coord.size();
+      }
+    }
+    return sum;
+  });
+  bench("split", vents, [](const std::string &line) {
+    size_t sum = 0;
+    for (const std::string &half : split(line, ' ')) {
+      for (const std::string &coord : split(half, ',')) {
+        sum += coord.size();
+      }
+    }
+    return sum;
+  });
+  bench("split_view", vents, [](const std::string &line) {
+    size_t sum = 0;
+    for (std::string_view half : split_view(line, ' ')) {
+      for (std::string_view coord : split_view(half, ',')) {
+        sum += coord.size();
+      }
+    }
+    return sum;
+  });
+  bench("split_view(\" -> \")", vents, [](const std::string &line) {
+    size_t sum = 0;
+    for (std::string_view point : split_view(line, " -> ")) {
+      sum += point.size();
+    }
+    return sum;
+  });
+  bench("split_view(AnyOf)", vents, [](const std::string &line) {
+    size_t sum = 0;
+    for (std::string_view coord : split_view(line, AnyOf(" ,->"))) {
+      sum += coord.size();
+    }
+    return sum;
+  });
+
+  // Day 12 style edges with long names, a few fields per line.
+  std::vector<std::string> words;
+  for (int i = 0; i < n; i++) {
+    std::string line;
+    for (int w = 0; w < 12; w++) {
+      line += std::string(1 + rng() % 10, 'a' + rng() % 26);
+      line += ' ';
+    }
+    words.push_back(line);
+  }
+  printf("\nLines of 12 words, %d lines\n", n);
+  bench("old split", words, [](const std::string &line) {
+    return oldSplit(line, ' ').size();
+  });
+  bench("split", words, [](const std::string &line) {
+    return split(line, ' ').size();
+  });
+  bench("split_view", words, [](const std::string &line) {
+    size_t count = 0;
+    for (std::string_view word : split_view(line, ' ')) {
+      count += !word.empty();
+    }
+    return count;
+  });
+  bench("Words", words, [](const std::string &line) {
+    size_t count = 0;
+    for (std::string_view word : Words(line)) {
+      count += !word.empty();
+    }
+    return count;
+  });
+
+  return 0;
+}
@@ -0,0 +1,123 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "../lib.h"
+
+// Scheduling overhead of ThreadPool against starting a std::thread per
+// task, on tasks that do about the same small amount of work: ns per task
+// above what running them in a plain loop takes.
+//
+// Usage: make bench/thread_pool && ./a.out [num_threads]
+
+template <typename F>
+double timeIt(F f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+// A few hundred nanoseconds of work that the compiler cannot drop.
+unsigned work(unsigned i) {
+  unsigned x = i;
+  for (int k = 0; k < 100; k++) {
+    x = x * 1664525 + 1013904223;
+  }
+  return x;
+}
+
+std::atomic<unsigned> sink{0};
+
+// Binary tree of tasks, each level spawning one half and running the other.
+unsigned spawnTree(ThreadPool *pool, int lo, int hi) {
+  if (hi - lo == 1) {
+    return work(lo);
+  }
+  const int mid = lo + (hi - lo) / 2;
+  unsigned left;
+  TaskGroup group(pool);
+  group.spawn([&] { left = spawnTree(pool, lo, mid); });
+  unsigned right = spawnTree(pool, mid, hi);
+  group.wait();
+  return left ^ right;
+}
+
+void report(const char *name, int n, double seconds, double loop_seconds) {
+  printf("  %-26s %8d tasks %10.1f ns/task %10.1f ns overhead\n", name, n,
+         seconds / n * 1e9, (seconds - loop_seconds) / n * 1e9);
+}
+
+int main(int argc, char *argv[]) {
+  ThreadPool pool(argc > 1 ? atoi(argv[1]) : 0);
+  printf("%d threads (%u hardware)\n", pool.size(),
+         std::thread::hardware_concurrency());
+
+  const int n = 200000;
+  const double loop = timeIt([&] {
+    unsigned x = 0;
+    for (int i = 0; i < n; i++) {
+      x ^= work(i);
+    }
+    sink ^= x;
+  });
+  report("plain loop", n, loop, loop);
+
+  // Starting threads is slow enough that fewer tasks do.
+  const int num_threads = 2000;
+  const double threads = timeIt([&] {
+    std::vector<std::thread> all;
+    for (int i = 0; i < num_threads; i++) {
+      all.emplace_back([i] { sink ^= work(i); });
+    }
+    for (auto &thread : all) {
+      thread.join();
+    }
+  });
+  report("std::thread per task", num_threads, threads,
+         loop * num_threads / n);
+
+  const double spawn = timeIt([&] {
+    TaskGroup group(&pool);
+    for (int i = 0; i < n; i++) {
+      group.spawn([i] { sink ^= work(i); });
+    }
+    group.wait();
+  });
+  report("TaskGroup::spawn", n, spawn, loop);
+
+  const double tree = timeIt([&] { sink ^= spawnTree(&pool, 0, n); });
+  report("nested spawn (tree)", n, tree, loop);
+
+  const double each = timeIt([&] {
+    parallel_for(0, n, [](int i) { sink ^= work(i); }, 1, &pool);
+  });
+  report("parallel_for, grain 1", n, each, loop);
+
+  const double chunked = timeIt([&] {
+    parallel_for_chunks(
+        0, n,
+        [](int begin, int end) {
+          unsigned x = 0;
+          for (int i = begin; i < end; i++) {
+            x ^= work(i);
+          }
+          sink ^= x;
+        },
+        0, &pool);
+  });
+  report("parallel_for_chunks", n, chunked, loop);
+
+  const double reduce = timeIt([&] {
+    sink ^= parallel_reduce(
+        0, n, 0u, work, [](unsigned a, unsigned b) { return a ^ b; }, 0,
+        &pool);
+  });
+  report("parallel_reduce", n, reduce, loop);
+
+  return 0;
+}
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cmath>
 #include <unordered_map>
 
+#include "hash.h"
+
 struct Pt {
   Pt() : x(0), y(0) {}
 
@@ -102,10 +105,7 @@ namespace std {
 
 template <>
 struct hash<Pt> {
-  size_t operator()(const Pt &k) const {
-    std::hash<int> hasher;
-    return hasher(k.x) ^ hasher(k.y);
-  }
+  size_t operator()(const Pt &k) const { return hashPoint(k.x, k.y); }
 };
 
 }  // namespace std
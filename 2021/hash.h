@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Hashing of small fixed-size keys. Two 32-bit coordinates are packed into
+// one 64-bit word and run through the murmur3 finalizer, so every input bit
+// affects every output bit. Unlike hash(x) ^ hash(y), (a, a) doesn't hash
+// to 0 and (a, b) doesn't collide with (b, a).
+
+inline uint64_t fmix64(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+inline uint64_t packKey(int32_t x, int32_t y) {
+  return (uint64_t)(uint32_t)x << 32 | (uint32_t)y;
+}
+
+inline size_t hashPoint(int32_t x, int32_t y) {
+  return (size_t)fmix64(packKey(x, y));
+}
@@ -1,11 +1,38 @@
 #pragma once
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cctype>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <numeric>  // for std::__gcd
+#include <type_traits>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "hash.h"
+
 // Useful classes
 
 struct Vec {
@@ -67,8 +94,8 @@ typename MapType::mapped_type lookupOr(MapType &m,
 }
 
 template <typename Container>
-bool contains(const Container &s, const typename Container::value_type &v) {
-  return s.find(v) != s.end();
+bool contains(const Container &s, const typename Container::key_type &k) {
+  return s.find(k) != s.end();
 }
 
 template <typename Container>
@@ -88,21 +115,21 @@ namespace std {
 
 template <>
 struct hash<Vec> {
-  size_t operator()(const Vec &v) const {
-    size_t h = 0;
-    hash_combine(h, v.x);
-    hash_combine(h, v.y);
-    return h;
-  }
+  size_t operator()(const Vec &v) const { return hashPoint(v.x, v.y); }
 };
 
 template <typename A, typename B>
 struct hash<std::pair<A, B>> {
   size_t operator()(const std::pair<A, B> &k) const {
-    size_t h = 0;
-    hash_combine(h, k.first);
-    hash_combine(h, k.second);
-    return h;
+    if constexpr (std::is_integral_v<A> && std::is_integral_v<B> &&
+                  sizeof(A) <= 4 && sizeof(B) <= 4) {
+      return hashPoint((int32_t)k.first, (int32_t)k.second);
+    } else {
+      size_t h = 0;
+      hash_combine(h, k.first);
+      hash_combine(h, k.second);
+      return (size_t)fmix64(h);
+    }
   }
 };
 
@@ -119,25 +146,1591 @@ struct hash<vector<string>> {
 
 }  // namespace std
 
-// String
+// Grids
 
-inline std::vector<std::string> split(const std::string &s, char delim) {
-  std::vector<std::string> pieces;
+// Dense grid over the box [origin.x, origin.x + width) x [origin.y,
+// origin.y + height), stored row-major in one vector. `border` extra rings of
+// cells around the box start with the fill value, so the neighbours of any
+// cell in the box can be read without bounds checks. ensure() grows the box
+// on any side, for maps of unknown size that are explored as we go.
+template <typename T>
+struct Grid2D {
+  using reference = typename std::vector<T>::reference;
+  using const_reference = typename std::vector<T>::const_reference;
+
+  Grid2D() : Grid2D(0, 0) {}
+
+  Grid2D(int width, int height, const T &fill = T(), int border = 0)
+      : Grid2D(Vec(0, 0), width, height, fill, border) {}
+
+  Grid2D(Vec origin, int width, int height, const T &fill = T(),
+         int border = 0)
+      : _origin(origin),
+        _width(width),
+        _height(height),
+        _border(border),
+        _stride(width + 2 * border),
+        _fill(fill),
+        _cells((size_t)(width + 2 * border) * (height + 2 * border), fill) {
+    assert(width >= 0 && height >= 0 && border >= 0);
+  }
+
+  int width() const { return _width; }
+  int height() const { return _height; }
+  int border() const { return _border; }
+  Vec origin() const { return _origin; }
+  const T &fillValue() const { return _fill; }
+
+  bool inBounds(Vec p) const {
+    return p.x >= _origin.x && p.y >= _origin.y &&
+           p.x < _origin.x + _width && p.y < _origin.y + _height;
+  }
+
+  // Unchecked: p must be in the box or its border.
+  reference operator[](Vec p) { return _cells[index(p)]; }
+  const_reference operator[](Vec p) const { return _cells[index(p)]; }
+
+  reference at(Vec p) {
+    assert(inBounds(p));
+    return (*this)[p];
+  }
+
+  // The fill value outside of the box.
+  T get(Vec p) const { return inBounds(p) ? (*this)[p] : _fill; }
+
+  // Grows the box to contain p, at least doubling it in each direction that
+  // grows so that exploring cell by cell is amortized O(1).
+  reference ensure(Vec p) {
+    if (!inBounds(p)) {
+      int x0 = _origin.x;
+      int y0 = _origin.y;
+      int x1 = _origin.x + _width;
+      int y1 = _origin.y + _height;
+      if (p.x < x0) x0 = std::min(p.x, x0 - std::max(_width, 1));
+      if (p.y < y0) y0 = std::min(p.y, y0 - std::max(_height, 1));
+      if (p.x >= x1) x1 = std::max(p.x + 1, x1 + std::max(_width, 1));
+      if (p.y >= y1) y1 = std::max(p.y + 1, y1 + std::max(_height, 1));
+      resize(Vec(x0, y0), x1 - x0, y1 - y0);
+    }
+    return (*this)[p];
+  }
+
+  // Moves the box, keeping the cells in both the old and the new one.
+  void resize(Vec origin, int width, int height) {
+    Grid2D g(origin, width, height, _fill, _border);
+    const int x0 = std::max(origin.x, _origin.x);
+    const int x1 = std::min(origin.x + width, _origin.x + _width);
+    const int y0 = std::max(origin.y, _origin.y);
+    const int y1 = std::min(origin.y + height, _origin.y + _height);
+    for (int y = y0; y < y1 && x0 < x1; y++) {
+      auto from = _cells.begin() + index(Vec(x0, y));
+      std::copy(from, from + (x1 - x0), g._cells.begin() + g.index(Vec(x0, y)));
+    }
+    *this = std::move(g);
+  }
+
+  void fill(const T &v) { std::fill(_cells.begin(), _cells.end(), v); }
+
+  // Flat indices, for BFS queues and parent links without Vec arithmetic.
+  // Moving by `step(d)` from the index of a cell in the box stays valid as
+  // long as it doesn't leave the border.
+  size_t index(Vec p) const {
+    return (size_t)(p.y - _origin.y + _border) * _stride +
+           (p.x - _origin.x + _border);
+  }
+
+  Vec pos(size_t i) const {
+    return Vec((int)(i % _stride) - _border + _origin.x,
+               (int)(i / _stride) - _border + _origin.y);
+  }
+
+  long step(Vec d) const { return (long)d.y * _stride + d.x; }
+
+  reference operator[](size_t i) { return _cells[i]; }
+  const_reference operator[](size_t i) const { return _cells[i]; }
+
+  // Number of cells, border included.
+  size_t size() const { return _cells.size(); }
+
+ private:
+  Vec _origin;
+  int _width;
+  int _height;
+  int _border;
+  int _stride;
+  T _fill;
+  std::vector<T> _cells;
+};
+
+// Bit grids
+
+// Bit-sliced counter: add(x) adds 1 to the count of every bit set in x, for
+// all bits at once. Bit i of each count is in bit[i]; counts that go past
+// 2^BITS - 1 are flagged in `overflow`. T is an unsigned integer or a GCC
+// vector of them; a vector wider than the target's registers changes the
+// ABI when passed or returned by value, so use equals(n, &mask) for those.
+template <typename T, int BITS>
+struct BitCounter {
+  void add(const T &value) {
+    T x = value;
+    for (int i = 0; i < BITS; i++) {
+      T carry = bit[i] & x;
+      bit[i] ^= x;
+      x = carry;
+    }
+    overflow |= x;
+  }
+
+  // The bits whose count is n.
+  T equals(unsigned n) const {
+    T mask;
+    equals(n, &mask);
+    return mask;
+  }
+
+  void equals(unsigned n, T *mask) const {
+    *mask = ~overflow;
+    for (int i = 0; i < BITS; i++) {
+      if ((n >> i) & 1) {
+        *mask &= bit[i];
+      } else {
+        *mask &= ~bit[i];
+      }
+    }
+  }
+
+  T bit[BITS]{};
+  T overflow{};
+};
+
+// Grid of bits over [0, width) x [0, height), for automata and flood fills
+// that work on 64 cells at a time. Each row is `stride` 64-bit words, with
+// cell x in bit x % 64 of word x / 64; the bits past the width are always
+// zero. Cells outside the grid read as zero.
+struct BitGrid {
+  BitGrid() : BitGrid(0, 0) {}
+
+  BitGrid(int width, int height)
+      : _width(width),
+        _height(height),
+        _stride((width + 63) / 64),
+        _words((size_t)_stride * height, 0) {
+    assert(width >= 0 && height >= 0);
+  }
+
+  int width() const { return _width; }
+  int height() const { return _height; }
+  int stride() const { return _stride; }
+
+  bool inBounds(Vec p) const {
+    return p.x >= 0 && p.y >= 0 && p.x < _width && p.y < _height;
+  }
+
+  bool get(Vec p) const {
+    return inBounds(p) && ((row(p.y)[p.x / 64] >> (p.x % 64)) & 1);
+  }
+
+  void set(Vec p, bool value = true) {
+    assert(inBounds(p));
+    uint64_t bit = 1ULL << (p.x % 64);
+    if (value) {
+      row(p.y)[p.x / 64] |= bit;
+    } else {
+      row(p.y)[p.x / 64] &= ~bit;
+    }
+  }
+
+  uint64_t *row(int y) { return &_words[(size_t)y * _stride]; }
+  const uint64_t *row(int y) const { return &_words[(size_t)y * _stride]; }
+
+  // All the words, row after row.
+  uint64_t *data() { return _words.data(); }
+  const uint64_t *data() const { return _words.data(); }
+  size_t size() const { return _words.size(); }
+
+  // The bits of word w of a row that are inside the grid.
+  uint64_t wordMask(int w) const {
+    if (w < _stride - 1 || _width % 64 == 0) {
+      return ~0ULL;
+    }
+    return (1ULL << (_width % 64)) - 1;
+  }
+
+  void fill(bool value) {
+    for (int y = 0; y < _height; y++) {
+      for (int w = 0; w < _stride; w++) {
+        row(y)[w] = value ? wordMask(w) : 0;
+      }
+    }
+  }
+
+  bool any() const {
+    for (uint64_t word : _words) {
+      if (word) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  int count() const {
+    int n = 0;
+    for (uint64_t word : _words) {
+      n += __builtin_popcountll(word);
+    }
+    return n;
+  }
+
+  int rowCount(int y) const {
+    int n = 0;
+    for (int w = 0; w < _stride; w++) {
+      n += __builtin_popcountll(row(y)[w]);
+    }
+    return n;
+  }
+
+  int columnCount(int x) const {
+    int n = 0;
+    for (int y = 0; y < _height; y++) {
+      n += (row(y)[x / 64] >> (x % 64)) & 1;
+    }
+    return n;
+  }
+
+  // Calls f(p) for every set cell, row by row.
+  template <typename F>
+  void forEach(F f) const {
+    for (int y = 0; y < _height; y++) {
+      for (int w = 0; w < _stride; w++) {
+        for (uint64_t word = row(y)[w]; word; word &= word - 1) {
+          f(Vec(w * 64 + __builtin_ctzll(word), y));
+        }
+      }
+    }
+  }
+
+  BitGrid &operator&=(const BitGrid &o) {
+    assert(o._width == _width && o._height == _height);
+    for (size_t i = 0; i < _words.size(); i++) _words[i] &= o._words[i];
+    return *this;
+  }
+
+  BitGrid &operator|=(const BitGrid &o) {
+    assert(o._width == _width && o._height == _height);
+    for (size_t i = 0; i < _words.size(); i++) _words[i] |= o._words[i];
+    return *this;
+  }
+
+  BitGrid &operator^=(const BitGrid &o) {
+    assert(o._width == _width && o._height == _height);
+    for (size_t i = 0; i < _words.size(); i++) _words[i] ^= o._words[i];
+    return *this;
+  }
+
+  // this &= ~o
+  BitGrid &andNot(const BitGrid &o) {
+    assert(o._width == _width && o._height == _height);
+    for (size_t i = 0; i < _words.size(); i++) _words[i] &= ~o._words[i];
+    return *this;
+  }
+
+  bool operator==(const BitGrid &o) const {
+    return _width == o._width && _height == o._height && _words == o._words;
+  }
+  bool operator!=(const BitGrid &o) const { return !(*this == o); }
+
+  // Word w of row y of the grid moved dx (-1, 0 or 1) cells along x, with
+  // zeros coming in from outside the grid.
+  uint64_t shiftedWord(int y, int w, int dx) const {
+    if (y < 0 || y >= _height) {
+      return 0;
+    }
+    const uint64_t *r = row(y);
+    if (dx > 0) {
+      uint64_t in = w > 0 ? r[w - 1] >> 63 : 0;
+      return ((r[w] << 1) | in) & wordMask(w);
+    }
+    if (dx < 0) {
+      uint64_t in = w + 1 < _stride ? r[w + 1] << 63 : 0;
+      return (r[w] >> 1) | in;
+    }
+    return r[w];
+  }
+
+  // The grid moved by d, with d.x and d.y in -1..1: cell p of the result is
+  // cell p - d of this one.
+  BitGrid shifted(Vec d) const {
+    BitGrid g(_width, _height);
+    for (int y = 0; y < _height; y++) {
+      for (int w = 0; w < _stride; w++) {
+        g.row(y)[w] = shiftedWord(y - d.y, w, d.x);
+      }
+    }
+    return g;
+  }
+
+  // Adds the set neighbours of the cells of word w of row y to n: the 8
+  // around each cell, or the 4 orthogonal ones.
+  template <typename Counter>
+  void addNeighbours(int y, int w, bool diagonals, Counter *n) const {
+    n->add(shiftedWord(y - 1, w, 0));
+    n->add(shiftedWord(y + 1, w, 0));
+    n->add(shiftedWord(y, w, -1));
+    n->add(shiftedWord(y, w, 1));
+    if (diagonals) {
+      n->add(shiftedWord(y - 1, w, -1));
+      n->add(shiftedWord(y - 1, w, 1));
+      n->add(shiftedWord(y + 1, w, -1));
+      n->add(shiftedWord(y + 1, w, 1));
+    }
+  }
 
-  std::string cur;
-  for (char c : s) {
-    if (c == delim) {
-      if (!cur.empty()) {
-        pieces.emplace_back(std::move(cur));
+  // Number of set neighbours of every cell, bit-sliced: bit i of the count
+  // of p is cell p of planes[i], for 4 planes.
+  void countNeighbours(bool diagonals, BitGrid *planes) const {
+    for (int i = 0; i < 4; i++) {
+      planes[i] = BitGrid(_width, _height);
+    }
+    for (int y = 0; y < _height; y++) {
+      for (int w = 0; w < _stride; w++) {
+        BitCounter<uint64_t, 4> n;
+        addNeighbours(y, w, diagonals, &n);
+        for (int i = 0; i < 4; i++) {
+          planes[i].row(y)[w] = n.bit[i];
+        }
+      }
+    }
+  }
+
+  // One generation of a cellular automaton, 64 cells at a time: each word
+  // of the next grid is rule(cells, counts), where counts is the
+  // BitCounter<uint64_t, 4> of their set neighbours.
+  template <typename Rule>
+  BitGrid step(bool diagonals, Rule rule) const {
+    BitGrid next(_width, _height);
+    for (int y = 0; y < _height; y++) {
+      for (int w = 0; w < _stride; w++) {
+        BitCounter<uint64_t, 4> n;
+        addNeighbours(y, w, diagonals, &n);
+        next.row(y)[w] = rule(row(y)[w], n) & wordMask(w);
       }
+    }
+    return next;
+  }
+
+  // The cells of `mask` that can be reached from the set cells of this grid
+  // by orthogonal steps within the mask. Sweeps down and then up, spreading
+  // along each word as far as it goes, until nothing changes.
+  BitGrid floodFill(const BitGrid &mask) const {
+    BitGrid fill = *this;
+    fill &= mask;
+    for (bool changed = true; changed;) {
+      changed = false;
+      for (int i = 0; i < 2 * _height; i++) {
+        const int y = i < _height ? i : 2 * _height - 1 - i;
+        for (int w = 0; w < _stride; w++) {
+          const uint64_t m = mask.row(y)[w];
+          uint64_t word = fill.row(y)[w];
+          uint64_t grown = (word | fill.shiftedWord(y - 1, w, 0) |
+                            fill.shiftedWord(y + 1, w, 0) |
+                            fill.shiftedWord(y, w, -1) |
+                            fill.shiftedWord(y, w, 1)) &
+                           m;
+          for (uint64_t prev = 0; grown != prev;) {
+            prev = grown;
+            grown = (grown | (grown << 1) | (grown >> 1)) & m;
+          }
+          if (grown != word) {
+            fill.row(y)[w] = grown;
+            changed = true;
+          }
+        }
+      }
+    }
+    return fill;
+  }
+
+  // Cell (x, y) of the result is cell (y, x) of this grid.
+  BitGrid transposed() const {
+    BitGrid t(_height, _width);
+    forEach([&](Vec p) { t.set(Vec(p.y, p.x)); });
+    return t;
+  }
+
+ private:
+  int _width;
+  int _height;
+  int _stride;
+  std::vector<uint64_t> _words;
+};
+
+namespace std {
+
+template <>
+struct hash<BitGrid> {
+  size_t operator()(const BitGrid &g) const {
+    uint64_t h = hashPoint(g.width(), g.height());
+    for (size_t i = 0; i < g.size(); i++) {
+      h = fmix64(h ^ g.data()[i]) + i;
+    }
+    return (size_t)h;
+  }
+};
+
+}  // namespace std
+
+// Flat hash tables
+
+// Control byte of a flat table slot: empty, deleted, or the low 7 bits of
+// the hash of the key stored in it.
+#define FLAT_EMPTY ((int8_t)-128)
+#define FLAT_DELETED ((int8_t)-2)
+#define FLAT_GROUP 16
+
+// Bit i is set if ctrl[i] == b, for a group of FLAT_GROUP control bytes.
+inline uint32_t flatMatch(const int8_t *ctrl, int8_t b) {
+#if defined(__SSE2__)
+  __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(b)));
+#else
+  uint32_t mask = 0;
+  for (int i = 0; i < FLAT_GROUP; i++) {
+    mask |= (uint32_t)(ctrl[i] == b) << i;
+  }
+  return mask;
+#endif
+}
+
+// Bit i is set if slot i of the group is empty or deleted (ctrl[i] < 0).
+inline uint32_t flatMatchFree(const int8_t *ctrl) {
+#if defined(__SSE2__)
+  return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+#else
+  uint32_t mask = 0;
+  for (int i = 0; i < FLAT_GROUP; i++) {
+    mask |= (uint32_t)(ctrl[i] < 0) << i;
+  }
+  return mask;
+#endif
+}
+
+// Open-addressing hash table in the style of Swiss tables. Each slot has a
+// control byte holding 7 bits of its key's hash, and lookups compare 16 of
+// them at once (SSE2), so keys are only compared on a likely match. Probing
+// is quadratic over aligned groups of 16 and stops at the first group with
+// an empty slot. Slots are stored inline: growing the table invalidates
+// iterators and references. Keys and values must be default-constructible.
+// Use FlatMap and FlatSet below.
+template <typename Key, typename Slot, typename KeyOf, typename Hash>
+struct FlatTable {
+  using key_type = Key;
+  using size_type = size_t;
+
+  template <typename T, typename Table>
+  struct Iter {
+    T &operator*() const { return table->_slots[i]; }
+    T *operator->() const { return &table->_slots[i]; }
+    Iter &operator++() {
+      i = table->nextFull(i + 1);
+      return *this;
+    }
+    bool operator==(const Iter &other) const { return i == other.i; }
+    bool operator!=(const Iter &other) const { return i != other.i; }
+
+    Table *table;
+    size_t i;
+  };
+
+  size_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+  size_t capacity() const { return _ctrl.size(); }
+
+  void clear() {
+    std::fill(_ctrl.begin(), _ctrl.end(), FLAT_EMPTY);
+    std::fill(_slots.begin(), _slots.end(), Slot());
+    _size = 0;
+    _deleted = 0;
+  }
+
+  void reserve(size_t n) {
+    if (n * 8 > capacity() * 7) {
+      rehash(n);
+    }
+  }
+
+  size_t count(const Key &k) const { return findIndex(k) != npos ? 1 : 0; }
+
+  size_t erase(const Key &k) {
+    size_t i = findIndex(k);
+    if (i == npos) {
+      return 0;
+    }
+    // No probe ever went past a group with an empty slot, so if this group
+    // has one the slot can become empty rather than a tombstone.
+    const int8_t *group = &_ctrl[i & ~(size_t)(FLAT_GROUP - 1)];
+    if (flatMatch(group, FLAT_EMPTY)) {
+      _ctrl[i] = FLAT_EMPTY;
     } else {
-      cur += c;
+      _ctrl[i] = FLAT_DELETED;
+      _deleted += 1;
+    }
+    _slots[i] = Slot();
+    _size -= 1;
+    return 1;
+  }
+
+ protected:
+  static constexpr size_t npos = ~(size_t)0;
+
+  // One multiply spreads the key's hash over the high bits, which are
+  // folded down into the probe start and the 7 control bits.
+  static size_t hash(const Key &k) {
+    uint64_t h = (uint64_t)Hash()(k) * 0x9e3779b97f4a7c15ULL;
+    return h ^ (h >> 32);
+  }
+
+  size_t findIndex(const Key &k) const {
+    if (_size == 0) {
+      return npos;
+    }
+    const size_t h = hash(k);
+    const int8_t h2 = (int8_t)(h & 0x7f);
+    const size_t group_mask = capacity() / FLAT_GROUP - 1;
+    size_t g = (h >> 7) & group_mask;
+    for (size_t step = 1;; step++) {
+      const int8_t *group = &_ctrl[g * FLAT_GROUP];
+      for (uint32_t m = flatMatch(group, h2); m; m &= m - 1) {
+        size_t i = g * FLAT_GROUP + __builtin_ctz(m);
+        if (KeyOf()(_slots[i]) == k) {
+          return i;
+        }
+      }
+      if (flatMatch(group, FLAT_EMPTY)) {
+        return npos;
+      }
+      g = (g + step) & group_mask;
+    }
+  }
+
+  // Index of the slot of k, inserting a default slot with key k if absent.
+  std::pair<size_t, bool> findOrInsertIndex(const Key &k) {
+    size_t i = findIndex(k);
+    if (i != npos) {
+      return {i, false};
+    }
+    if ((_size + _deleted + 1) * 8 > capacity() * 7) {
+      // only grow if tombstones are not the reason for being full
+      rehash((_size + 1) * 2 > capacity() ? _size + 1 : _size);
     }
+    const size_t h = hash(k);
+    i = freeIndex(h);
+    if (_ctrl[i] == FLAT_DELETED) {
+      _deleted -= 1;
+    }
+    _ctrl[i] = (int8_t)(h & 0x7f);
+    KeyOf()(_slots[i]) = k;
+    _size += 1;
+    return {i, true};
+  }
+
+  size_t nextFull(size_t i) const {
+    while (i < _ctrl.size() && _ctrl[i] < 0) {
+      i++;
+    }
+    return i;
+  }
+
+  std::vector<int8_t> _ctrl;
+  std::vector<Slot> _slots;
+
+ private:
+  size_t freeIndex(size_t h) const {
+    const size_t group_mask = capacity() / FLAT_GROUP - 1;
+    size_t g = (h >> 7) & group_mask;
+    for (size_t step = 1;; step++) {
+      uint32_t m = flatMatchFree(&_ctrl[g * FLAT_GROUP]);
+      if (m) {
+        return g * FLAT_GROUP + __builtin_ctz(m);
+      }
+      g = (g + step) & group_mask;
+    }
+  }
+
+  // Rebuilds the table with room for n keys below the 7/8 load factor.
+  void rehash(size_t n) {
+    size_t cap = FLAT_GROUP;
+    while (n * 8 > cap * 7) {
+      cap *= 2;
+    }
+    std::vector<int8_t> old_ctrl(cap, FLAT_EMPTY);
+    std::vector<Slot> old_slots(cap);
+    std::swap(old_ctrl, _ctrl);
+    std::swap(old_slots, _slots);
+    _deleted = 0;
+    for (size_t i = 0; i < old_ctrl.size(); i++) {
+      if (old_ctrl[i] >= 0) {
+        size_t j = freeIndex(hash(KeyOf()(old_slots[i])));
+        _ctrl[j] = old_ctrl[i];
+        _slots[j] = std::move(old_slots[i]);
+      }
+    }
+  }
+
+  size_t _size = 0;
+  size_t _deleted = 0;
+};
+
+struct FlatMapKey {
+  template <typename Slot>
+  auto &operator()(Slot &slot) const {
+    return slot.first;
+  }
+};
+
+struct FlatSetKey {
+  template <typename Slot>
+  Slot &operator()(Slot &slot) const {
+    return slot;
+  }
+};
+
+// Drop-in for std::unordered_map in the common cases (find, [], emplace,
+// erase, iteration), with the FlatTable caveats. Entries are
+// std::pair<K, V>: the key must not be modified through an iterator.
+template <typename K, typename V, typename Hash = std::hash<K>>
+struct FlatMap : FlatTable<K, std::pair<K, V>, FlatMapKey, Hash> {
+  using Base = FlatTable<K, std::pair<K, V>, FlatMapKey, Hash>;
+  using mapped_type = V;
+  using value_type = std::pair<K, V>;
+  using iterator = typename Base::template Iter<value_type, FlatMap>;
+  using const_iterator =
+      typename Base::template Iter<const value_type, const FlatMap>;
+
+  iterator begin() { return iterator{this, this->nextFull(0)}; }
+  iterator end() { return iterator{this, this->capacity()}; }
+  const_iterator begin() const { return {this, this->nextFull(0)}; }
+  const_iterator end() const { return {this, this->capacity()}; }
+
+  iterator find(const K &k) {
+    size_t i = this->findIndex(k);
+    return i != Base::npos ? iterator{this, i} : end();
+  }
+
+  const_iterator find(const K &k) const {
+    size_t i = this->findIndex(k);
+    return i != Base::npos ? const_iterator{this, i} : end();
+  }
+
+  V &operator[](const K &k) {
+    return this->_slots[this->findOrInsertIndex(k).first].second;
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const K &k, Args &&...args) {
+    auto [i, inserted] = this->findOrInsertIndex(k);
+    if (inserted) {
+      this->_slots[i].second = V(std::forward<Args>(args)...);
+    }
+    return {iterator{this, i}, inserted};
   }
-  if (!cur.empty()) {
-    pieces.emplace_back(std::move(cur));
+
+  std::pair<iterator, bool> emplace(const K &k, const V &v) {
+    return try_emplace(k, v);
+  }
+
+  std::pair<iterator, bool> insert(const value_type &kv) {
+    return try_emplace(kv.first, kv.second);
   }
+};
 
+// Drop-in for std::unordered_set, with the FlatTable caveats.
+template <typename K, typename Hash = std::hash<K>>
+struct FlatSet : FlatTable<K, K, FlatSetKey, Hash> {
+  using Base = FlatTable<K, K, FlatSetKey, Hash>;
+  using value_type = K;
+  using iterator = typename Base::template Iter<const K, const FlatSet>;
+  using const_iterator = iterator;
+
+  iterator begin() const { return {this, this->nextFull(0)}; }
+  iterator end() const { return {this, this->capacity()}; }
+
+  iterator find(const K &k) const {
+    size_t i = this->findIndex(k);
+    return i != Base::npos ? iterator{this, i} : end();
+  }
+
+  std::pair<iterator, bool> insert(const K &k) {
+    auto [i, inserted] = this->findOrInsertIndex(k);
+    return {iterator{this, i}, inserted};
+  }
+
+  std::pair<iterator, bool> emplace(const K &k) { return insert(k); }
+};
+
+// Memory
+
+// Bump allocator: memory comes from big blocks, one after the other, and is
+// only given back all at once, by reset() or release(). Objects made in it
+// are never destroyed, so they should not own anything outside it. Blocks
+// double in size, starting at `first_block` bytes. Not thread-safe.
+//
+// It is a std::pmr::memory_resource, for std::pmr containers whose nodes
+// are freed all together:
+//   Arena arena;
+//   std::pmr::unordered_map<Vec, int> memo(&arena);
+struct Arena : std::pmr::memory_resource {
+  explicit Arena(size_t first_block = 4096) : _next_size(first_block) {}
+
+  ~Arena() override { release(); }
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  void *allocateBytes(size_t bytes, size_t align) {
+    uintptr_t p = ((uintptr_t)_ptr + align - 1) & ~(uintptr_t)(align - 1);
+    if (p + bytes > (uintptr_t)_end) {
+      return allocateSlow(bytes, align);
+    }
+    _ptr = (char *)(p + bytes);
+    return (void *)p;
+  }
+
+  // Memory for n objects of type T, not constructed.
+  template <typename T>
+  T *allocateArray(size_t n) {
+    return (T *)allocateBytes(n * sizeof(T), alignof(T));
+  }
+
+  template <typename T, typename... Args>
+  T *make(Args &&...args) {
+    return new (allocateArray<T>(1)) T(std::forward<Args>(args)...);
+  }
+
+  // Frees everything but the largest block, which later allocations reuse:
+  // a loop that resets the arena once per round stops calling malloc once
+  // the block fits a round.
+  void reset() {
+    if (_blocks.empty()) {
+      return;
+    }
+    auto largest = std::max_element(
+        _blocks.begin(), _blocks.end(),
+        [](const Block &a, const Block &b) { return a.size < b.size; });
+    std::swap(*largest, _blocks.back());
+    for (size_t i = 0; i + 1 < _blocks.size(); i++) {
+      ::operator delete(_blocks[i].data);
+    }
+    _blocks.erase(_blocks.begin(), _blocks.end() - 1);
+    _ptr = _blocks.back().data;
+    _end = _ptr + _blocks.back().size;
+  }
+
+  // Frees everything.
+  void release() {
+    for (Block &b : _blocks) {
+      ::operator delete(b.data);
+    }
+    _blocks.clear();
+    _ptr = _end = nullptr;
+  }
+
+  // Bytes taken from the heap, and in how many blocks.
+  size_t capacity() const {
+    size_t total = 0;
+    for (const Block &b : _blocks) {
+      total += b.size;
+    }
+    return total;
+  }
+  size_t numBlocks() const { return _blocks.size(); }
+
+ private:
+  struct Block {
+    char *data;
+    size_t size;
+  };
+
+  void *allocateSlow(size_t bytes, size_t align) {
+    const size_t size = std::max(_next_size, bytes + align);
+    _next_size = size * 2;
+    _blocks.push_back(Block{(char *)::operator new(size), size});
+    _ptr = _blocks.back().data;
+    _end = _ptr + size;
+    return allocateBytes(bytes, align);
+  }
+
+  void *do_allocate(size_t bytes, size_t align) override {
+    return allocateBytes(bytes, align);
+  }
+
+  void do_deallocate(void *, size_t, size_t) override {}
+
+  bool do_is_equal(
+      const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+  std::vector<Block> _blocks;
+  char *_ptr = nullptr;
+  char *_end = nullptr;
+  size_t _next_size;
+};
+
+// Objects of one type that come and go: make() constructs a T, destroy()
+// runs its destructor and keeps its slot on a free list for the next
+// make(). New slots come from an Arena, the pool's own or a shared one. The
+// pool does not destroy the objects still alive when it goes away, and
+// their memory goes with the arena's. The free list points into the arena:
+// after a shared arena is reset or released, reset() the pool too before
+// using it again.
+//   ObjectPool<Node> pool;
+//   Node *n = pool.make(1, 2);
+//   pool.destroy(n);
+template <typename T>
+struct ObjectPool {
+  explicit ObjectPool(Arena *arena = nullptr)
+      : _arena(arena ? arena : &_own) {}
+
+  ObjectPool(const ObjectPool &) = delete;
+  ObjectPool &operator=(const ObjectPool &) = delete;
+
+  template <typename... Args>
+  T *make(Args &&...args) {
+    Slot *slot = _free;
+    if (slot) {
+      _free = slot->next;
+    } else {
+      slot = _arena->allocateArray<Slot>(1);
+    }
+    _live++;
+    return new (slot->storage) T(std::forward<Args>(args)...);
+  }
+
+  void destroy(T *p) {
+    p->~T();
+    Slot *slot = reinterpret_cast<Slot *>(p);
+    slot->next = _free;
+    _free = slot;
+    _live--;
+  }
+
+  // Forgets every object, without destroying them, and the free list. The
+  // pool's own arena is reset with it; a shared one is left to its owner.
+  void reset() {
+    _free = nullptr;
+    _live = 0;
+    if (_arena == &_own) {
+      _own.reset();
+    }
+  }
+
+  // Objects made and not destroyed yet.
+  size_t live() const { return _live; }
+
+ private:
+  union Slot {
+    Slot *next;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  Arena _own;
+  Arena *_arena;
+  Slot *_free = nullptr;
+  size_t _live = 0;
+};
+
+// Threads
+
+struct TaskGroup;
+
+// Work-stealing thread pool. Each worker thread has a deque of tasks: it
+// pushes and pops its own tasks at the back, newest first, and when it runs
+// out it steals the oldest task at the front of another deque, which for a
+// range split in halves is the biggest piece left. Tasks spawned by threads
+// outside the pool go to one more deque, shared by them. The deques are
+// locked, but only for a push or a pop. Idle workers sleep until a task is
+// pushed.
+//
+// A thread waiting for a TaskGroup runs queued tasks in the meantime, so
+// tasks can spawn and wait for tasks of their own, and a pool of size n
+// has n - 1 workers: the waiting thread is the n-th. With size 1 the
+// waiting thread runs everything.
+struct ThreadPool {
+  // num_threads <= 0: one per hardware thread.
+  explicit ThreadPool(int num_threads = 0) {
+    if (num_threads <= 0) {
+      num_threads = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+    _size = num_threads;
+    for (int i = 0; i < num_threads; i++) {
+      _queues.emplace_back(new Queue);  // the last one is the shared deque
+    }
+    for (int i = 0; i + 1 < num_threads; i++) {
+      _workers.emplace_back([this, i] { workerLoop(i); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(_sleep_mutex);
+      _stop = true;
+    }
+    _wake.notify_all();
+    for (auto &worker : _workers) {
+      worker.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // How many threads run tasks, counting the one that waits.
+  int size() const { return _size; }
+
+  // The pool parallel_for() and the others use by default, started on
+  // first use.
+  static ThreadPool &global() {
+    static ThreadPool pool;
+    return pool;
+  }
+
+ private:
+  friend struct TaskGroup;
+
+  struct Task {
+    std::function<void()> run;
+    TaskGroup *group;
+  };
+
+  struct alignas(64) Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  // The pool the calling thread works for, if any, and its deque there.
+  struct Worker {
+    const ThreadPool *pool = nullptr;
+    int queue = 0;
+  };
+
+  static Worker &currentWorker() {
+    static thread_local Worker worker;
+    return worker;
+  }
+
+  int ownQueue() const {
+    const Worker &worker = currentWorker();
+    return worker.pool == this ? worker.queue : (int)_queues.size() - 1;
+  }
+
+  void push(Task task) {
+    Queue &q = *_queues[ownQueue()];
+    {
+      std::lock_guard<std::mutex> lock(q.mutex);
+      q.tasks.push_back(std::move(task));
+    }
+    _queued.fetch_add(1);
+    if (_sleeping.load() > 0) {
+      { std::lock_guard<std::mutex> lock(_sleep_mutex); }
+      _wake.notify_one();
+    }
+  }
+
+  // Takes the newest task of the calling thread's deque, or else steals
+  // the oldest of another one.
+  bool take(Task *task) {
+    const int own = ownQueue();
+    const int n = (int)_queues.size();
+    for (int k = 0; k < n; k++) {
+      Queue &q = *_queues[(own + k) % n];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (q.tasks.empty()) {
+        continue;
+      }
+      if (k == 0) {
+        *task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+      } else {
+        *task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+      }
+      _queued.fetch_sub(1);
+      return true;
+    }
+    return false;
+  }
+
+  bool runOne();
+
+  void wakeAll() {
+    if (_sleeping.load() > 0) {
+      { std::lock_guard<std::mutex> lock(_sleep_mutex); }
+      _wake.notify_all();
+    }
+  }
+
+  // Sleeps until a task is queued or done() holds. _sleeping goes up
+  // before done() is checked, and the threads that make done() true, or
+  // queue tasks, only skip the notify if they see no sleepers; so one of
+  // the two sides always sees the other.
+  template <typename Done>
+  void sleep(Done done) {
+    std::unique_lock<std::mutex> lock(_sleep_mutex);
+    _sleeping.fetch_add(1);
+    _wake.wait(lock, [&] { return _queued.load() > 0 || done(); });
+    _sleeping.fetch_sub(1);
+  }
+
+  // Queued tasks are often taken before they could be stolen: spin a
+  // little before sleeping.
+  template <typename Done>
+  void idle(Done done) {
+    for (int spin = 0; spin < 64; spin++) {
+      if (_queued.load() > 0 || done()) {
+        return;
+      }
+      std::this_thread::yield();
+    }
+    sleep(done);
+  }
+
+  void workerLoop(int queue) {
+    currentWorker() = Worker{this, queue};
+    for (;;) {
+      if (runOne()) {
+        continue;
+      }
+      if (_stop.load()) {
+        return;
+      }
+      idle([this] { return _stop.load(); });
+    }
+  }
+
+  void waitFor(const TaskGroup &group);
+
+  int _size;
+  std::vector<std::unique_ptr<Queue>> _queues;
+  std::vector<std::thread> _workers;
+  std::atomic<int> _queued{0};  // tasks in all the deques
+  std::atomic<int> _sleeping{0};
+  std::atomic<bool> _stop{false};
+  std::mutex _sleep_mutex;
+  std::condition_variable _wake;
+};
+
+// Tasks spawned together, to wait for all at once. spawn() may be called
+// from inside the tasks; the destructor waits.
+//
+//   TaskGroup group;
+//   group.spawn([&] { left = solve(a); });
+//   right = solve(b);
+//   group.wait();
+struct TaskGroup {
+  explicit TaskGroup(ThreadPool *pool = &ThreadPool::global()) : _pool(pool) {}
+
+  ~TaskGroup() { wait(); }
+
+  TaskGroup(const TaskGroup &) = delete;
+  TaskGroup &operator=(const TaskGroup &) = delete;
+
+  template <typename F>
+  void spawn(F f) {
+    _pending.fetch_add(1);
+    _pool->push(ThreadPool::Task{std::function<void()>(std::move(f)), this});
+  }
+
+  // Runs queued tasks, of this group or not, until the group's are done.
+  void wait() { _pool->waitFor(*this); }
+
+  bool done() const { return _pending.load() == 0; }
+
+  ThreadPool *pool() const { return _pool; }
+
+ private:
+  friend struct ThreadPool;
+
+  void finish() {
+    ThreadPool *pool = _pool;  // the group may be gone once _pending is 0
+    if (_pending.fetch_sub(1) == 1) {
+      pool->wakeAll();
+    }
+  }
+
+  ThreadPool *_pool;
+  std::atomic<int> _pending{0};
+};
+
+inline bool ThreadPool::runOne() {
+  Task task;
+  if (!take(&task)) {
+    return false;
+  }
+  task.run();
+  task.group->finish();
+  return true;
+}
+
+inline void ThreadPool::waitFor(const TaskGroup &group) {
+  while (!group.done()) {
+    if (!runOne()) {
+      idle([&group] { return group.done(); });
+    }
+  }
+}
+
+// Chunk size of a parallel loop over n indices when none is given: about
+// 8 chunks per thread, so that stealing evens out uneven chunks, or a
+// single chunk for a single thread.
+inline int defaultGrain(int n, const ThreadPool &pool) {
+  if (pool.size() == 1) {
+    return std::max(n, 1);
+  }
+  return std::max(1, (n + 8 * pool.size() - 1) / (8 * pool.size()));
+}
+
+// f(chunk_begin, chunk_end) for the chunks of `grain` indices (the last one
+// may be shorter) that make up [begin, end), in parallel and in no
+// particular order. The chunks are handed out by splitting the range in
+// halves, so that thieves take big pieces. For loops that set up some state
+// per chunk; see parallel_for() otherwise.
+template <typename F>
+void parallel_for_chunks(int begin, int end, F f, int grain = 0,
+                         ThreadPool *pool = &ThreadPool::global()) {
+  if (end <= begin) {
+    return;
+  }
+  if (grain <= 0) {
+    grain = defaultGrain(end - begin, *pool);
+  }
+  const int num_chunks = (int)(((long long)end - begin + grain - 1) / grain);
+  if (num_chunks == 1) {
+    f(begin, end);
+    return;
+  }
+
+  struct Loop {
+    Loop(ThreadPool *pool, F &f, int begin, int end, int grain)
+        : group(pool), f(f), begin(begin), end(end), grain(grain) {}
+
+    // Chunks [lo, hi).
+    void run(int lo, int hi) {
+      while (hi - lo > 1) {
+        const int mid = lo + (hi - lo) / 2;
+        group.spawn([this, mid, hi] { run(mid, hi); });
+        hi = mid;
+      }
+      const int chunk_begin = begin + lo * grain;
+      f(chunk_begin, std::min(end, chunk_begin + grain));
+    }
+
+    TaskGroup group;
+    F &f;
+    int begin, end, grain;
+  };
+
+  Loop loop(pool, f, begin, end, grain);
+  loop.run(0, num_chunks);
+  loop.group.wait();
+}
+
+// f(i) for every i in [begin, end), in parallel.
+//   parallel_for(0, n, [&](int i) { out[i] = solve(in[i]); });
+template <typename F>
+void parallel_for(int begin, int end, F f, int grain = 0,
+                  ThreadPool *pool = &ThreadPool::global()) {
+  parallel_for_chunks(
+      begin, end,
+      [&f](int chunk_begin, int chunk_end) {
+        for (int i = chunk_begin; i < chunk_end; i++) {
+          f(i);
+        }
+      },
+      grain, pool);
+}
+
+// reduce(... reduce(reduce(identity, map(begin)), map(begin + 1)) ...,
+// map(end - 1)) for an associative reduce, with the maps in parallel. Each
+// chunk is reduced on its own, then the chunks in order, so the result
+// does not depend on the scheduling even if reduce is not commutative.
+//   int best = parallel_reduce(0, n, 0, score, [](int a, int b) {
+//     return std::max(a, b);
+//   });
+template <typename T, typename Map, typename Reduce>
+T parallel_reduce(int begin, int end, T identity, Map map, Reduce reduce,
+                  int grain = 0, ThreadPool *pool = &ThreadPool::global()) {
+  if (end <= begin) {
+    return identity;
+  }
+  if (grain <= 0) {
+    grain = defaultGrain(end - begin, *pool);
+  }
+  const int num_chunks = (int)(((long long)end - begin + grain - 1) / grain);
+  struct Partial {
+    T value;  // not in a std::vector<T>, which could be a vector<bool>
+  };
+  std::vector<Partial> partial(num_chunks, Partial{identity});
+  parallel_for_chunks(
+      begin, end,
+      [&](int chunk_begin, int chunk_end) {
+        T acc = identity;
+        for (int i = chunk_begin; i < chunk_end; i++) {
+          acc = reduce(std::move(acc), map(i));
+        }
+        partial[(chunk_begin - begin) / grain].value = std::move(acc);
+      },
+      grain, pool);
+
+  T result = std::move(identity);
+  for (Partial &p : partial) {
+    result = reduce(std::move(result), std::move(p.value));
+  }
+  return result;
+}
+
+// Input
+
+// The whole input in memory, followed by at least one NUL byte. Regular
+// files are mmap'd: the rest of the last page reads as zeros. Pipes, and
+// files that end exactly on a page boundary, are read into a page-aligned
+// buffer instead.
+struct Input {
+  // Reads stdin if path is null. Exits with an error if it can't be opened.
+  explicit Input(const char *path = nullptr) {
+    int fd = STDIN_FILENO;
+    if (path) {
+      fd = open(path, O_RDONLY);
+      if (fd < 0) {
+        perror(path);
+        exit(1);
+      }
+    }
+    const size_t page = sysconf(_SC_PAGESIZE);
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+        st.st_size % page != 0) {
+      void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        madvise(p, st.st_size, MADV_SEQUENTIAL);
+        _data = (char *)p;
+        _size = st.st_size;
+        _mapped = true;
+      }
+    }
+    if (!_mapped) {
+      slurp(fd, page);
+    }
+    if (path) {
+      close(fd);
+    }
+  }
+
+  ~Input() {
+    if (_mapped) {
+      munmap(_data, _size);
+    } else {
+      free(_data);
+    }
+  }
+
+  Input(const Input &) = delete;
+  Input &operator=(const Input &) = delete;
+
+  const char *data() const { return _data; }
+  size_t size() const { return _size; }
+  std::string_view text() const { return std::string_view(_data, _size); }
+
+ private:
+  void slurp(int fd, size_t page) {
+    size_t capacity = 0;
+    for (;;) {
+      if (_size + page >= capacity) {
+        // grow by doubling, keeping room for the NUL
+        size_t new_capacity = std::max(capacity * 2, (size_t)16 * page);
+        void *p = nullptr;
+        if (posix_memalign(&p, page, new_capacity) != 0) {
+          perror("posix_memalign");
+          exit(1);
+        }
+        if (_data) {
+          memcpy(p, _data, _size);
+          free(_data);
+        }
+        _data = (char *)p;
+        capacity = new_capacity;
+      }
+      ssize_t n = read(fd, _data + _size, capacity - _size - 1);
+      if (n <= 0) {
+        break;
+      }
+      _size += n;
+    }
+    _data[_size] = '\0';
+  }
+
+  char *_data = nullptr;
+  size_t _size = 0;
+  bool _mapped = false;
+};
+
+// Reads the lines of a text one at a time, without their '\n' (or "\r\n").
+// A last line without a '\n' is still a line.
+struct LineReader {
+  explicit LineReader(std::string_view text)
+      : _p(text.data()), _end(text.data() + text.size()) {}
+
+  bool next(std::string_view *line) {
+    if (_p == _end) {
+      return false;
+    }
+    const char *nl = (const char *)memchr(_p, '\n', _end - _p);
+    const char *line_end = nl ? nl : _end;
+    *line = std::string_view(_p, line_end - _p);
+    if (!line->empty() && line->back() == '\r') {
+      line->remove_suffix(1);
+    }
+    _p = nl ? nl + 1 : _end;
+    return true;
+  }
+
+  bool done() const { return _p == _end; }
+
+ private:
+  const char *_p;
+  const char *_end;
+};
+
+// for (std::string_view line : Lines(input.text())) { ... }
+struct Lines {
+  struct iterator {
+    std::string_view operator*() const { return _line; }
+    iterator &operator++() {
+      _done = !_reader.next(&_line);
+      return *this;
+    }
+    bool operator!=(const iterator &other) const {
+      return _done != other._done;
+    }
+
+    LineReader _reader;
+    std::string_view _line;
+    bool _done;
+  };
+
+  explicit Lines(std::string_view text) : _text(text) {}
+
+  iterator begin() const {
+    iterator it{LineReader(_text), {}, false};
+    return ++it;
+  }
+  iterator end() const { return iterator{LineReader({}), {}, true}; }
+
+ private:
+  std::string_view _text;
+};
+
+// Reads the integers in a text, skipping everything else. For signed types
+// a '-' right before the digits makes the number negative, unless it follows
+// a digit (as in ranges like "3-5").
+struct NumberScanner {
+  explicit NumberScanner(std::string_view text)
+      : _begin(text.data()), _p(text.data()), _end(text.data() + text.size()) {}
+
+  template <typename T>
+  bool next(T *out) {
+    static_assert(std::is_integral_v<T>, "NumberScanner reads integers");
+    while (_p < _end && (unsigned)(*_p - '0') > 9) {
+      _p++;
+    }
+    if (_p == _end) {
+      return false;
+    }
+    bool negative = false;
+    if constexpr (std::is_signed_v<T>) {
+      negative = _p > _begin && _p[-1] == '-' &&
+                 (_p - 1 == _begin || (unsigned)(_p[-2] - '0') > 9);
+    }
+    std::make_unsigned_t<T> v = 0;
+    for (unsigned d; _p < _end && (d = (unsigned)(*_p - '0')) <= 9; _p++) {
+      v = v * 10 + d;
+    }
+    *out = negative ? (T)(0 - v) : (T)v;
+    return true;
+  }
+
+  // The text that hasn't been scanned yet.
+  std::string_view rest() const { return std::string_view(_p, _end - _p); }
+
+ private:
+  const char *_begin;
+  const char *_p;
+  const char *_end;
+};
+
+// String
+
+// Delimiters for split_view(). find(p, end) returns the first delimiter at
+// or after p, or end if there is none; size() is the delimiter's length.
+
+// One character, found with memchr.
+struct CharDelim {
+  const char *find(const char *p, const char *end) const {
+    const char *d = (const char *)memchr(p, _c, end - p);
+    return d ? d : end;
+  }
+  size_t size() const { return 1; }
+
+  char _c;
+};
+
+// A string of one or more characters: memchr for its first character, then
+// a compare of the rest.
+struct StringDelim {
+  const char *find(const char *p, const char *end) const {
+    const size_t n = _s.size();
+    while ((size_t)(end - p) >= n) {
+      const char *d = (const char *)memchr(p, _s[0], end - p - n + 1);
+      if (!d) {
+        break;
+      }
+      if (memcmp(d + 1, _s.data() + 1, n - 1) == 0) {
+        return d;
+      }
+      p = d + 1;
+    }
+    return end;
+  }
+  size_t size() const { return _s.size(); }
+
+  std::string_view _s;
+};
+
+// Any one character of a set, as in split_view(line, AnyOf(" ,;")). With
+// SSE2, 16 bytes are compared against each character of the set at once.
+struct AnyOf {
+  explicit AnyOf(std::string_view chars) : _chars(chars) {
+    assert(!chars.empty());
+    for (unsigned char c : chars) {
+      _bits[c / 64] |= 1ULL << (c % 64);
+    }
+  }
+
+  bool matches(char c) const {
+    return (_bits[(unsigned char)c / 64] >> ((unsigned char)c % 64)) & 1;
+  }
+
+  const char *find(const char *p, const char *end) const {
+#if defined(__SSE2__)
+    for (; end - p >= 16; p += 16) {
+      __m128i block = _mm_loadu_si128((const __m128i *)p);
+      __m128i hit = _mm_setzero_si128();
+      for (char c : _chars) {
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(block, _mm_set1_epi8(c)));
+      }
+      uint32_t mask = (uint32_t)_mm_movemask_epi8(hit);
+      if (mask) {
+        return p + __builtin_ctz(mask);
+      }
+    }
+#endif
+    while (p < end && !matches(*p)) {
+      p++;
+    }
+    return p;
+  }
+  size_t size() const { return 1; }
+
+  std::string_view _chars;
+  uint64_t _bits[4] = {};
+};
+
+// The non-empty pieces of a text between delimiters, as string_views into
+// the text; nothing is copied. Runs of delimiters count as one, as in
+// split(). The text (and a string delimiter) must outlive the view.
+//   for (std::string_view field : split_view(line, ',')) ...
+template <typename Delim>
+struct SplitView {
+  struct iterator {
+    std::string_view operator*() const {
+      return std::string_view(_p, _token_end - _p);
+    }
+    iterator &operator++() {
+      _p = _token_end;
+      skip();
+      return *this;
+    }
+    bool operator!=(const iterator &other) const { return _p != other._p; }
+
+    // Skips delimiters at _p, then finds where the token starting there ends.
+    void skip() {
+      while (_p < _end) {
+        _token_end = _delim.find(_p, _end);
+        if (_token_end != _p) {
+          return;
+        }
+        _p += _delim.size();
+      }
+      _p = _token_end = _end;
+    }
+
+    const char *_p;
+    const char *_token_end;
+    const char *_end;
+    Delim _delim;
+  };
+
+  SplitView(std::string_view text, Delim delim) : _text(text), _delim(delim) {
+    assert(delim.size() > 0);
+  }
+
+  iterator begin() const {
+    const char *end = _text.data() + _text.size();
+    iterator it{_text.data(), end, end, _delim};
+    it.skip();
+    return it;
+  }
+  iterator end() const {
+    const char *end = _text.data() + _text.size();
+    return iterator{end, end, end, _delim};
+  }
+
+  std::vector<std::string_view> to_vector() const {
+    std::vector<std::string_view> pieces;
+    for (std::string_view piece : *this) {
+      pieces.push_back(piece);
+    }
+    return pieces;
+  }
+
+ private:
+  std::string_view _text;
+  Delim _delim;
+};
+
+// Whitespace-separated fields: for (std::string_view w : Words(line)) ...
+struct Words : SplitView<AnyOf> {
+  explicit Words(std::string_view text)
+      : SplitView<AnyOf>(text, AnyOf(" \t\n\v\f\r")) {}
+};
+
+inline SplitView<CharDelim> split_view(std::string_view s, char delim) {
+  return SplitView<CharDelim>(s, CharDelim{delim});
+}
+
+inline SplitView<StringDelim> split_view(std::string_view s,
+                                         std::string_view delim) {
+  return SplitView<StringDelim>(s, StringDelim{delim});
+}
+
+inline SplitView<AnyOf> split_view(std::string_view s, const AnyOf &delims) {
+  return SplitView<AnyOf>(s, delims);
+}
+
+inline std::vector<std::string> split(const std::string &s, char delim) {
+  std::vector<std::string> pieces;
+  for (std::string_view piece : split_view(s, delim)) {
+    pieces.emplace_back(piece);
+  }
   return pieces;
 }
 
@@ -1,7 +1,8 @@
 #include <cassert>
 #include <cstdint>
 #include <cstdio>
-#include <string>
+
+#include "lib.h"
 
 int64_t reference_impl(const char *in) {
   bool first_digit_found = false;
@@ -98,48 +99,15 @@ done:
   return sum;
 }
 
-int run(const std::string &input) {
-  const int64_t sum = reference_impl(input.c_str());
+int run(const char *input) {
+  const int64_t sum = reference_impl(input);
   printf("%lld\n", sum);
   return 0;
 }
 
+// Usage: ./a.out [in]  (reads stdin without a file)
 int main(int argc, char **argv) {
-  std::string input;
-  int ret = 0;
-  int64_t file_size = 0;
-  const char *err = "fopen";
-  FILE *file = fopen(argv[1], "r");
-  if (!file) {
-    goto error;
-  }
-  if (fseek(file, 0, SEEK_END) != 0) {
-    err = "fseek";
-    goto error;
-  }
-  file_size = ftell(file);
-  if (file_size < 0) {
-    err = "ftell";
-    goto error;
-  }
-  if (fseek(file, 0, SEEK_SET) != 0) {
-    err = "fseek";
-    goto error;
-  }
-  assert(file_size > 0);
-  input.resize(file_size);
-  if (fread(input.data(), 1, file_size, file) < 0) {
-    err = "fread";
-    goto error;
-  }
-  ret = run(input);
-  goto cleanup;
-error:
-  perror(err);
-  ret = 1;
-cleanup:
-  if (file) {
-    fclose(file);
-  }
-  return ret;
+  // reference_impl() relies on the NUL after the input
+  Input input(argc > 1 ? argv[1] : nullptr);
+  return run(input.data());
 }
@@ -1,8 +1,7 @@
 #include <cassert>
 #include <cstdio>
-#include <queue>
-#include <stack>
-#include <set>
+#include <cstdlib>
+#include <optional>
 #include <vector>
 
 #include "lib.h"
@@ -99,47 +98,35 @@ void print_map() {
   putchar('\n');
 }
 
-std::optional<Vec> first_neigh_in_cycle(int x, int y,
-                                        const std::set<Vec> &cycle,
-                                        const std::vector<Vec> &all_so_far) {
-  std::optional<Vec> ret;
-  ForEachNeigh(x, y,
-               [x, y, &ret, &cycle, &all_so_far](int neigh_x, int neigh_y) {
-                 auto neigh = Vec{neigh_x, neigh_y};
-                 if (!ret.has_value() && contains(cycle, neigh) &&
-                     !linearContains(all_so_far, neigh)) {
-                   assert(neigh != (Vec{x, y}));
-                   ret = neigh;
-                   return true;  // break
-                 }
-                 return false;  // continue
-               });
-  return ret;
-}
-
-std::vector<Vec> orient_corners(const std::set<Vec> &cycle) {
-  auto pos = start;
-  std::vector<Vec> all_so_far;
-  std::vector<Vec> ret;
-  for (;;) {
-    all_so_far.push_back(pos);
-    int x = pos.x;
-    int y = pos.y;
-    char c = map[y][x];
-    const bool is_corner =
-        c == 'S' || c == 'F' || c == 'L' || c == '7' || c == 'J';
-    if (is_corner) {
-      ret.push_back({x, y});
-    }
-    auto next_pos = first_neigh_in_cycle(x, y, cycle, all_so_far);
-    if (!next_pos.has_value()) {
-      break;
+// The tiles of the loop through the start, in order from the start. The
+// start may also connect to pipes that are not on the loop, so each of its
+// neighbours is tried in turn: every other pipe tile connects to two tiles,
+// and following them either comes back to the start or dead-ends.
+std::vector<Vec> find_loop() {
+  std::vector<Vec> loop;
+  ForEachNeigh(start.x, start.y, [&loop](int x, int y) {
+    loop = {start};
+    Vec prev = start;
+    Vec pos{x, y};
+    while (pos != start) {
+      loop.push_back(pos);
+      std::optional<Vec> next;
+      ForEachNeigh(pos.x, pos.y, [&next, prev](int neigh_x, int neigh_y) {
+        if (Vec{neigh_x, neigh_y} == prev) {
+          return false;  // continue
+        }
+        next = Vec{neigh_x, neigh_y};
+        return true;  // break
+      });
+      if (!next.has_value()) {
+        return false;  // dead end, try the next neighbour of the start
+      }
+      prev = pos;
+      pos = *next;
     }
-    pos = *next_pos;
-    // printf("-  %d,%d -> %d,%d\n", x, y, pos.first, pos.second);
-    if (linearContains(all_so_far, pos)) break;
-  }
-  return ret;
+    return true;  // break
+  });
+  return loop;
 }
 
 int main() {
@@ -170,67 +157,24 @@ int main() {
 done:
   n = y;
 
-  struct State {
-    Vec pos;
-    int dist;
+  // The farthest tile is halfway around the loop.
+  auto loop = find_loop();
+  assert(loop.size() >= 4 && loop.size() % 2 == 0);
+  printf("Part 1: %d\n", (int)loop.size() / 2);
 
-    State(Vec pos, int dist) : pos(pos), dist(dist) {}
-  };
-
-  std::stack<State> s;
-  s.push(State(start, 0));
-  std::set<Vec> visited;
-  while (!s.empty()) {
-    auto v = s.top();
-    int x = v.pos.x;
-    int y = v.pos.y;
-    int dist = v.dist;
-    s.pop();
-    puts(":");
-    if (v.pos == start && visited.count(start)) {
-      // XXX: extract
-      const int half_dist = (dist + 1) / 2;
-      printf("already visited %d,%d (dist = %d, half-dist = %d)\n", x, y, dist, half_dist);
-      auto &cycle = visited;
-      puts("orienting corners...");
-      auto corners = orient_corners(cycle);
-      for (int y = 0; y < n; y++) {
-        for (int x = 0; x < m; x++) {
-          if (!contains(cycle, {x, y})) {
-            map[y][x] = '.';
-          }
-        }
-      }
-      print_map();
-
-      int shoelace = 0;
-      corners.push_back(corners[0]);
-      for (int i = 0; i < corners.size() - 1; i++) {
-        auto [x0, y0] = corners[i];
-        auto [x1, y1] = corners[i + 1];
-        shoelace += (y0 + y1) * (x0 - x1);
-      }
-      assert(shoelace % 2 == 0);
-      auto area = (shoelace - (int)visited.size() + 3) / 2;
-      printf("area = %d\n", area);
-      break;
-    }
-    if (visited.count(v.pos)) {
-      continue;
-    }
-    visited.insert(v.pos);
-    ForEachNeigh(x, y, [&, dist](int neigh_x, int neigh_y) {
-      auto neigh = Vec{neigh_x, neigh_y};
-      assert(map[neigh_y][neigh_x] != '.');
-      if (visited.count(neigh) == 0) {
-        s.emplace(neigh, dist + 1);
-      }
-      // XXX: continue here
-      // if (neigh == start) {
-      // }
-      return false;  // continue
-    });
+  // Shoelace over the loop gives twice its area (tiles between corners are
+  // on straight lines and add nothing), and by Pick's theorem the tiles
+  // inside are area - boundary / 2 + 1.
+  loop.push_back(loop[0]);
+  int shoelace = 0;
+  for (size_t i = 0; i + 1 < loop.size(); i++) {
+    auto [x0, y0] = loop[i];
+    auto [x1, y1] = loop[i + 1];
+    shoelace += (y0 + y1) * (x0 - x1);
   }
+  const int boundary = (int)loop.size() - 1;
+  const int inside = (std::abs(shoelace) - boundary + 2) / 2;
+  printf("Part 2: %d\n", inside);
 
   return 0;
 }
@@ -1,154 +1,101 @@
 #include <cassert>
 #include <cstdio>
 #include <optional>
+#include <string_view>
 #include <vector>
 
 #include "lib.h"
 
-struct XAxis {
-  int size;
-  int &operator()(Vec &v) { return v.x; }
-};
-
-struct YAxis {
-  int size;
-  int &operator()(Vec &v) { return v.y; }
-};
-
-template <class Axis>
-struct Forward {
-  Axis axis;
-  Forward(Axis axis) : axis(axis) {}
-  void start(Vec &v) { axis(v) = 0; }
-  void next(Vec &v) { axis(v) += 1; }
-  bool done(Vec &v) { return axis(v) >= axis.size; }
-};
-
-template <class Axis>
-struct Backward {
-  Axis axis;
-  Backward(Axis axis) : axis(axis) {}
-  void start(Vec &v) { axis(v) = axis.size - 1; }
-  void next(Vec &v) { axis(v) -= 1; }
-  bool done(Vec &v) { return axis(v) < 0; }
-};
+// Slides every rock toward row 0 (dy = -1) or the last row (dy = 1) until
+// it stops at a wall, another rock or the edge, 64 columns at a time. Rows
+// are settled starting from that edge, so each rock only has to look at the
+// rows that are already final.
+void Slide(BitGrid *rocks, const BitGrid &walls, int dy) {
+  const int n = rocks->height();
+  for (int i = 1; i < n; i++) {
+    const int y = dy < 0 ? i : n - 1 - i;
+    for (int w = 0; w < rocks->stride(); w++) {
+      uint64_t moving = rocks->row(y)[w];
+      rocks->row(y)[w] = 0;
+      int k = y;  // the row of the moving rocks
+      while (moving && k + dy >= 0 && k + dy < n) {
+        uint64_t free = ~(rocks->row(k + dy)[w] | walls.row(k + dy)[w]);
+        rocks->row(k)[w] |= moving & ~free;
+        moving &= free;
+        k += dy;
+      }
+      rocks->row(k)[w] |= moving;
+    }
+  }
+}
 
+// Rocks and walls as bit grids. West and east tilts slide the rocks along
+// the rows of the transposed grids.
 struct Grid {
-  static const int MAX_N = 100;
   int n = 0, m = 0;
-  char map[MAX_N][MAX_N];
-
-  void Clear() { n = m = 0; }
-
-  static bool ParseGrid(Grid *grid) {
-    grid->Clear();
-    int x = 0;
-    int y = 0;
-    for (;;) {
-      char c = getchar();
-      switch (c) {
-        case '\n':
-          if (x == 0) {
-            goto done_parsing;
-          }
-          if (y == 0 && grid->m == 0) {
-            grid->m = x;
-          }
-          x = 0;
-          y += 1;
-          break;
-        case 'O':
-        case '.':
-        case '#':
-          grid->map[y][x] = c;
-          x += 1;
-          break;
-        case EOF:
-          if (y == 0) {
-            return false;
-          }
-          goto done_parsing;
-        default:
-          assert(false);
+  BitGrid rocks;
+  BitGrid walls;
+  BitGrid walls_t;  // transposed
+
+  // Reads lines up to a blank line or the end of the input.
+  static bool ParseGrid(LineReader *lines, Grid *grid) {
+    std::vector<std::string_view> rows;
+    std::string_view line;
+    while (lines->next(&line) && !line.empty()) {
+      rows.push_back(line);
+    }
+    grid->n = rows.size();
+    grid->m = rows.empty() ? 0 : rows[0].size();
+    grid->rocks = BitGrid(grid->m, grid->n);
+    grid->walls = BitGrid(grid->m, grid->n);
+    for (int y = 0; y < grid->n; y++) {
+      assert((int)rows[y].size() == grid->m);
+      for (int x = 0; x < grid->m; x++) {
+        char c = rows[y][x];
+        assert(c == 'O' || c == '.' || c == '#');
+        if (c == 'O') grid->rocks.set(Vec(x, y));
+        if (c == '#') grid->walls.set(Vec(x, y));
       }
     }
-  done_parsing:
-    grid->n = y;
-    return true;
+    grid->walls_t = grid->walls.transposed();
+    return grid->n > 0;
   }
 
-  char &operator[](Vec pos) { return map[pos.y][pos.x]; }
-
   void PrintMap() {
     for (int y = 0; y < n; y++) {
-      for (int x = 0; x < m; x++) putchar(map[y][x]);
+      for (int x = 0; x < m; x++) {
+        Vec pos(x, y);
+        putchar(rocks.get(pos) ? 'O' : walls.get(pos) ? '#' : '.');
+      }
       putchar('\n');
     }
     putchar('\n');
   }
 
-  size_t Hash() {
-    size_t h = 0;
-    std::hash<std::string_view> sv_hasher;
-    for (int y = 0; y < n; y++) {
-      hash_combine(h, sv_hasher(std::string_view(map[y], m)));
-    }
-    return h;
-  }
+  size_t Hash() { return std::hash<BitGrid>()(rocks); }
 
   int TotalNorthLoad() {
     int sum = 0;
     for (int y = 0; y < n; y++) {
-      for (int x = 0; x < m; x++) {
-        if (map[y][x] == 'O') sum += n - y;
-      }
+      sum += rocks.rowCount(y) * (n - y);
     }
     return sum;
   }
 
-  // clang-format off
-  std::pair<Backward<XAxis>, Forward<YAxis>>  North() { return {Backward{XAxis{m}}, Forward{YAxis{n}}}; }
-  std::pair<Forward<XAxis>,  Backward<YAxis>> South() { return {Forward{XAxis{m}},  Backward{YAxis{n}}}; }
-  std::pair<Backward<YAxis>, Forward<XAxis>>  West()  { return {Backward{YAxis{n}}, Forward{XAxis{m}}}; }
-  std::pair<Forward<YAxis>,  Backward<XAxis>> East()  { return {Forward{YAxis{n}},  Backward{XAxis{m}}}; }
-  // clang-format on
-
-  template <class Direction>
-  void Tilt(Direction dir) {
-    auto outer = dir.first;
-    auto inner = dir.second;
-    Vec pos0;
-    for (outer.start(pos0); !outer.done(pos0); outer.next(pos0)) {
-      for (inner.start(pos0); !inner.done(pos0); inner.next(pos0)) {
-        Vec delta;
-        Vec pos1 = pos0;
-        for (; !inner.done(pos1); inner.next(pos1)) {
-          char c = (*this)[pos1];
-          if (c == 'O') {
-            (*this)[pos1] = '.';
-            (*this)[pos0 + delta] = 'O';
-            inner.next(delta);
-          } else if (c == '.') {
-            continue;
-          } else if (c == '#') {
-            break;
-          }
-        }
-        inner.axis(pos0) = inner.axis(pos1);
-      }
-    }
-  }
-
   int TiltNorth() {
-    Tilt(North());
+    Slide(&rocks, walls, -1);
     return TotalNorthLoad();
   }
 
   int NWSECycle() {
-    Tilt(North());
-    Tilt(West());
-    Tilt(South());
-    Tilt(East());
+    Slide(&rocks, walls, -1);
+    BitGrid rocks_t = rocks.transposed();
+    Slide(&rocks_t, walls_t, -1);  // west
+    rocks = rocks_t.transposed();
+    Slide(&rocks, walls, 1);
+    rocks_t = rocks.transposed();
+    Slide(&rocks_t, walls_t, 1);  // east
+    rocks = rocks_t.transposed();
     return TotalNorthLoad();
   }
 };
@@ -160,9 +107,12 @@ std::optional<int> find(const std::vector<T> &v, T val) {
   return it - v.begin();
 }
 
+// Usage: ./a.out < in
 int main() {
+  Input input;
+  LineReader lines(input.text());
   Grid grid;
-  Grid::ParseGrid(&grid);
+  Grid::ParseGrid(&lines, &grid);
   {
     Grid grid0 = grid;
     int sum = grid0.TiltNorth();
@@ -1,32 +1,23 @@
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
-#include <queue>
-#include <set>
+#include <utility>
+#include <vector>
 
-struct Vec {
-  int x, y;
-
-  Vec(int x, int y) : x(x), y(y) {}
-
-  Vec operator+(Vec b) const { return Vec(x + b.x, y + b.y); }
-
-  bool operator<(const Vec &other) const {
-    return x < other.x || (x == other.x && y < other.y);
-  }
-
-  bool operator==(const Vec &other) const {
-    return x == other.x && y == other.y;
-  }
-};
+#include "lib.h"
+#include "search.h"
 
 enum Dir { N, W, S, E };
 
 struct Grid {
-  static const int MAX_N = 110;
   int n = 0, m = 0;
-  char map[MAX_N][MAX_N];
+  // n rows of m tiles, in a border of '\0' cells where beams leave the grid
+  Grid2D<char> map{0, 0, '\0', 1};
 
-  void Clear() { n = m = 0; }
+  void Clear() {
+    n = m = 0;
+    map = Grid2D<char>(0, 0, '\0', 1);
+  }
 
   static bool ParseGrid(Grid *grid) {
     grid->Clear();
@@ -50,7 +41,7 @@ struct Grid {
         case '/':
         case '\\':
         case '.':
-          grid->map[y][x] = c;
+          grid->map.ensure(Vec{x, y}) = c;
           x += 1;
           break;
         case EOF:
@@ -64,10 +55,11 @@ struct Grid {
     }
   done_parsing:
     grid->n = y;
+    grid->map.resize(Vec{0, 0}, grid->m, grid->n);
     return true;
   }
 
-  char &operator[](Vec pos) { return map[pos.y][pos.x]; }
+  char &operator[](Vec pos) { return map[pos]; }
 
   bool WithinBounds(Vec pos) {
     return pos.x >= 0 && pos.x < m && pos.y >= 0 && pos.y < n;
@@ -87,77 +79,85 @@ struct Grid {
       case E: return WEST;
     }
   }
+  // clang-format on
 
-  void CountEnergized0(std::set<std::pair<Vec, Dir>> &visited, Vec origin, Dir from) {
-    assert(WithinBounds(origin));
-    std::queue<std::pair<Vec, Dir>> queue;
-    queue.emplace(origin, from);
-
-    while (!queue.empty()) {
-      auto front = queue.front();
-      queue.pop();
-      auto [v, from] = front;
-      if (!WithinBounds(v) ||visited.count(front)) continue;
-      visited.insert(front);
-      const char c = (*this)[v];
-      if (c == '.') {
-        queue.emplace(v + opposite(from), from);
-      } else if (c == '-') {
-        switch (from) {
-          case N:
-          case S:
-            queue.emplace(v + EAST, W);
-            queue.emplace(v + WEST, E);
-            break;
-          case W:
-          case E:
-            queue.emplace(v + opposite(from), from);
-            break;
-        }
-      } else if (c == '|') {
-        switch (from) {
-          case N:
-          case S:
-            queue.emplace(v + opposite(from), from);
-            break;
-          case W:
-          case E:
-            queue.emplace(v + NORTH, S);
-            queue.emplace(v + SOUTH, N);
-            break;
-        }
-      } else if (c == '\\') {
-        switch (from) {
-          case N: queue.emplace(v + EAST,  W); break;
-          case W: queue.emplace(v + SOUTH, N); break;
-          case S: queue.emplace(v + WEST,  E); break;
-          case E: queue.emplace(v + NORTH, S); break;
-        }
-      } else if (c == '/') {
-        switch (from) {
-          case N: queue.emplace(v + WEST,  E); break;
-          case W: queue.emplace(v + NORTH, S); break;
-          case S: queue.emplace(v + EAST,  W); break;
-          case E: queue.emplace(v + SOUTH, N); break;
-        }
-      } else {
-        assert(false && "unreachable");
+  // A beam entering pos, coming from the side `from`.
+  struct Beam {
+    Vec pos;
+    Dir from = N;
+  };
+
+  // clang-format off
+  template <typename F>
+  void ForEachBeam(const Beam &beam, F &&emit) {
+    auto go = [&](Vec d, Dir from) {
+      if ((*this)[beam.pos + d] != '\0') emit(Beam{beam.pos + d, from});
+    };
+    const Dir from = beam.from;
+    const char c = (*this)[beam.pos];
+    if (c == '.') {
+      go(opposite(from), from);
+    } else if (c == '-') {
+      switch (from) {
+        case N:
+        case S:
+          go(EAST, W);
+          go(WEST, E);
+          break;
+        case W:
+        case E:
+          go(opposite(from), from);
+          break;
       }
+    } else if (c == '|') {
+      switch (from) {
+        case N:
+        case S:
+          go(opposite(from), from);
+          break;
+        case W:
+        case E:
+          go(NORTH, S);
+          go(SOUTH, N);
+          break;
+      }
+    } else if (c == '\\') {
+      switch (from) {
+        case N: go(EAST,  W); break;
+        case W: go(SOUTH, N); break;
+        case S: go(WEST,  E); break;
+        case E: go(NORTH, S); break;
+      }
+    } else if (c == '/') {
+      switch (from) {
+        case N: go(WEST,  E); break;
+        case W: go(NORTH, S); break;
+        case S: go(EAST,  W); break;
+        case E: go(SOUTH, N); break;
+      }
+    } else {
+      assert(false && "unreachable");
     }
   }
   // clang-format on
 
   int CountEnergized(Vec origin, Dir from) {
-    std::set<std::pair<Vec, Dir>> visited;
-    CountEnergized0(visited, origin, from);
-    auto it = visited.begin();
-    if (it == visited.end()) return 0;
-    auto pos = it->first;
-    int count = 1;
-    for (++it; it != visited.end(); ++it) {
-      if (pos != it->first) {
-        pos = it->first;
-        count += 1;
+    assert(WithinBounds(origin));
+    auto visited = denseStates<Beam, int>(
+        map.size() * 4,
+        [this](const Beam &b) { return map.index(b.pos) * 4 + b.from; });
+    bfs(&visited, Beam{origin, from},
+        [this](const Beam &beam, auto emit) { ForEachBeam(beam, emit); });
+
+    int count = 0;
+    for (int y = 0; y < n; y++) {
+      for (int x = 0; x < m; x++) {
+        for (Dir d : {N, W, S, E}) {
+          if (visited.reached(Beam{Vec{x, y}, d})) {
+            count += 1;
+            break;
+          }
+        }
       }
     }
     return count;
@@ -171,17 +171,22 @@ int main() {
   int count1 = grid.CountEnergized(Vec{0, 0}, W);
   printf("Part 1: %d\n", count1);
 
-  int count2 = 0;
+  // every edge tile, entered from outside the grid
+  std::vector<std::pair<Vec, Dir>> origins;
   for (int x = 0; x < grid.m; x++) {
-    count2 =
-        std::max(count2, std::max(grid.CountEnergized(Vec{x, 0}, N),
-                                  grid.CountEnergized(Vec{x, grid.n - 1}, S)));
+    origins.emplace_back(Vec{x, 0}, N);
+    origins.emplace_back(Vec{x, grid.n - 1}, S);
   }
   for (int y = 0; y < grid.n; y++) {
-    count2 =
-        std::max(count2, std::max(grid.CountEnergized(Vec{0, y}, W),
-                                  grid.CountEnergized(Vec{grid.m - 1, y}, E)));
+    origins.emplace_back(Vec{0, y}, W);
+    origins.emplace_back(Vec{grid.m - 1, y}, E);
   }
+  int count2 = parallel_reduce(
+      0, (int)origins.size(), 0,
+      [&](int i) {
+        return grid.CountEnergized(origins[i].first, origins[i].second);
+      },
+      [](int a, int b) { return std::max(a, b); });
   printf("Part 2: %d\n", count2);
   return 0;
 }
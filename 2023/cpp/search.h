@@ -0,0 +1,372 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Shortest paths over implicit graphs. A search is put together from:
+//  - states, of any copyable and default-constructible type, and a
+//    neighbour generator: neighbours(s, emit) calls emit(t, w) for every
+//    edge s -> t of weight w >= 0, or emit(t) for bfs();
+//  - a store of the best cost (and optionally the parent) of every state
+//    reached: DenseStates when states map to small integers, HashedStates
+//    otherwise;
+//  - a priority queue: BucketQueue for small integer weights, RadixHeap
+//    for larger integer ones, HeapQueue for anything else.
+// emit() returns true when it found a cheaper way to t, so that callers can
+// attach their own data to states as they are reached.
+//
+//   auto states = denseStates<Vec, int>(w * h, [&](Vec p) { ... });
+//   BucketQueue<Vec, int> queue(9);
+//   dijkstra(&states, &queue, start, [&](Vec p, auto emit) {
+//     for (Vec d : dirs) emit(p + d, risk(p + d));
+//   }, [&](Vec p) { return p == end; });
+//   int cost = states.cost(end);
+
+// State stores
+
+// States with an index(s) in [0, size): costs and parents are kept in flat
+// vectors. Use denseStates() to deduce the type of the index function.
+template <typename State, typename Cost, typename Index>
+struct DenseStates {
+  using state_type = State;
+  using cost_type = Cost;
+
+  static constexpr Cost UNREACHED = std::numeric_limits<Cost>::max();
+
+  DenseStates(size_t size, Index index, bool track_parents = false)
+      : _index(index), _cost(size, UNREACHED) {
+    if (track_parents) {
+      _parent.resize(size);
+    }
+  }
+
+  bool reached(const State &s) const { return _cost[_index(s)] != UNREACHED; }
+
+  // s must have been reached.
+  Cost cost(const State &s) const { return _cost[_index(s)]; }
+
+  // The state s was reached from; the source is its own parent.
+  const State &parent(const State &s) const {
+    assert(!_parent.empty());
+    return _parent[_index(s)];
+  }
+
+  // Number of states reached.
+  size_t size() const { return _reached; }
+
+  // Records cost c for s, reached from parent, if it is the first cost or a
+  // lower one.
+  bool improve(const State &s, Cost c, const State &parent) {
+    const size_t i = _index(s);
+    assert(i < _cost.size());
+    if (_cost[i] <= c) {
+      return false;
+    }
+    _reached += _cost[i] == UNREACHED;
+    _cost[i] = c;
+    if (!_parent.empty()) {
+      _parent[i] = parent;
+    }
+    return true;
+  }
+
+  void clear() {
+    std::fill(_cost.begin(), _cost.end(), UNREACHED);
+    _reached = 0;
+  }
+
+ private:
+  Index _index;
+  std::vector<Cost> _cost;
+  std::vector<State> _parent;
+  size_t _reached = 0;
+};
+
+template <typename State, typename Cost, typename Index>
+DenseStates<State, Cost, Index> denseStates(size_t size, Index index,
+                                            bool track_parents = false) {
+  return DenseStates<State, Cost, Index>(size, index, track_parents);
+}
+
+// Any hashable states, in a map such as std::unordered_map or FlatMap.
+template <typename State, typename Cost,
+          template <typename...> class Map = std::unordered_map>
+struct HashedStates {
+  using state_type = State;
+  using cost_type = Cost;
+
+  explicit HashedStates(bool track_parents = false)
+      : _track_parents(track_parents) {}
+
+  bool reached(const State &s) const { return _cost.find(s) != _cost.end(); }
+
+  Cost cost(const State &s) const { return _cost.find(s)->second; }
+
+  const State &parent(const State &s) const {
+    assert(_track_parents);
+    return _parent.find(s)->second;
+  }
+
+  size_t size() const { return _cost.size(); }
+
+  bool improve(const State &s, Cost c, const State &parent) {
+    auto [it, inserted] = _cost.try_emplace(s, c);
+    if (!inserted) {
+      if (it->second <= c) {
+        return false;
+      }
+      it->second = c;
+    }
+    if (_track_parents) {
+      _parent[s] = parent;
+    }
+    return true;
+  }
+
+  void clear() {
+    _cost.clear();
+    _parent.clear();
+  }
+
+  // f(state, cost) for every state reached.
+  template <typename F>
+  void forEach(F f) const {
+    for (const auto &[s, c] : _cost) {
+      f(s, c);
+    }
+  }
+
+ private:
+  bool _track_parents;
+  Map<State, Cost> _cost;
+  Map<State, State> _parent;
+};
+
+// The states on the way from the source to target, both included. The
+// store must track parents.
+template <typename States, typename State>
+std::vector<State> path(const States &states, State target) {
+  std::vector<State> p{target};
+  while (!(states.parent(p.back()) == p.back())) {
+    p.push_back(states.parent(p.back()));
+  }
+  std::reverse(p.begin(), p.end());
+  return p;
+}
+
+// Priority queues. All have push(key, state), pop(&key, &state) for one of
+// the entries with the lowest key, and empty().
+
+// Dial's algorithm: a ring of FIFO buckets, one per key from the last key
+// popped up to that plus max_step, the most a key can grow along an edge
+// (the largest weight, for Dijkstra). Keys must not go below the last key
+// popped. Push and pop are O(1) amortized, and with unit weights states
+// come out in BFS order.
+template <typename State, typename Cost>
+struct BucketQueue {
+  explicit BucketQueue(Cost max_step) : _buckets((size_t)max_step + 1) {
+    assert(max_step >= 0);
+  }
+
+  bool empty() const { return _size == 0; }
+
+  void push(Cost key, const State &s) {
+    if (!_popped && (empty() || key < _key)) {
+      _key = key;  // the ring starts at the lowest key pushed
+    }
+    assert(key >= _key && (size_t)(key - _key) < _buckets.size());
+    _buckets[(size_t)key % _buckets.size()].items.push_back(s);
+    _size++;
+  }
+
+  void pop(Cost *key, State *s) {
+    assert(!empty());
+    for (;;) {
+      Bucket &b = _buckets[(size_t)_key % _buckets.size()];
+      if (b.head < b.items.size()) {
+        *key = _key;
+        *s = b.items[b.head++];
+        _size--;
+        _popped = true;
+        return;
+      }
+      b.items.clear();
+      b.head = 0;
+      _key++;
+    }
+  }
+
+ private:
+  struct Bucket {
+    std::vector<State> items;
+    size_t head = 0;
+  };
+
+  std::vector<Bucket> _buckets;
+  Cost _key = 0;
+  size_t _size = 0;
+  bool _popped = false;
+};
+
+// Radix heap for non-negative integer keys that never go below the last key
+// popped. Bucket i > 0 holds the keys whose highest bit that differs from
+// the last key popped is bit i - 1. When bucket 0 runs out, the next
+// non-empty bucket is spread around its minimum; an entry only ever moves
+// to lower buckets, so a pop is O(log C) amortized for keys up to C.
+template <typename State, typename Cost>
+struct RadixHeap {
+  static_assert(std::is_integral_v<Cost>, "RadixHeap needs integer keys");
+
+  bool empty() const { return _size == 0; }
+
+  void push(Cost key, const State &s) {
+    assert(key >= _last);
+    _buckets[bucketOf(key)].emplace_back(key, s);
+    _size++;
+  }
+
+  void pop(Cost *key, State *s) {
+    assert(!empty());
+    if (_buckets[0].empty()) {
+      int i = 1;
+      while (_buckets[i].empty()) {
+        i++;
+      }
+      _last = _buckets[i][0].first;
+      for (auto &e : _buckets[i]) {
+        _last = std::min(_last, e.first);
+      }
+      for (auto &e : _buckets[i]) {
+        _buckets[bucketOf(e.first)].push_back(std::move(e));
+      }
+      _buckets[i].clear();
+    }
+    *key = _buckets[0].back().first;
+    *s = std::move(_buckets[0].back().second);
+    _buckets[0].pop_back();
+    _size--;
+  }
+
+ private:
+  int bucketOf(Cost key) const {
+    uint64_t diff = (uint64_t)key ^ (uint64_t)_last;
+    return diff == 0 ? 0 : 64 - __builtin_clzll(diff);
+  }
+
+  std::vector<std::pair<Cost, State>> _buckets[65];
+  Cost _last = 0;
+  size_t _size = 0;
+};
+
+// Binary heap, for costs that are not integers.
+template <typename State, typename Cost>
+struct HeapQueue {
+  bool empty() const { return _heap.empty(); }
+
+  void push(Cost key, const State &s) { _heap.push(Entry{key, s}); }
+
+  void pop(Cost *key, State *s) {
+    *key = _heap.top().key;
+    *s = _heap.top().state;
+    _heap.pop();
+  }
+
+ private:
+  struct Entry {
+    bool operator<(const Entry &other) const { return key > other.key; }
+
+    Cost key;
+    State state;
+  };
+
+  std::priority_queue<Entry> _heap;
+};
+
+// Searches. Each runs from source until goal(s) holds for a state it takes
+// out of the queue, and returns that state, or nullopt once everything
+// reachable has been seen. The costs (and parents) are left in `states`.
+
+struct NoGoal {
+  template <typename State>
+  bool operator()(const State &) const {
+    return false;
+  }
+};
+
+// A* with a consistent heuristic: h(s) <= w + h(t) for every edge s -> t of
+// weight w, and h(goal) = 0. States are popped in order of cost + h, which
+// never decreases, so the monotone queues above work.
+template <typename States, typename Queue, typename State, typename Neighbours,
+          typename Goal, typename Heuristic>
+std::optional<State> astar(States *states, Queue *queue, const State &source,
+                           Neighbours neighbours, Goal goal,
+                           Heuristic heuristic) {
+  using Cost = typename States::cost_type;
+  states->improve(source, Cost(0), source);
+  queue->push(heuristic(source), source);
+
+  State s;
+  Cost key;
+  while (!queue->empty()) {
+    queue->pop(&key, &s);
+    const Cost cost = states->cost(s);
+    if (key != cost + heuristic(s)) {
+      continue;  // stale: s was reached again at a lower cost
+    }
+    if (goal(s)) {
+      return s;
+    }
+    neighbours(s, [&](const State &t, Cost w) {
+      if (!states->improve(t, cost + w, s)) {
+        return false;
+      }
+      queue->push(cost + w + heuristic(t), t);
+      return true;
+    });
+  }
+  return std::nullopt;
+}
+
+template <typename States, typename Queue, typename State, typename Neighbours,
+          typename Goal = NoGoal>
+std::optional<State> dijkstra(States *states, Queue *queue, const State &source,
+                              Neighbours neighbours, Goal goal = Goal()) {
+  using Cost = typename States::cost_type;
+  return astar(states, queue, source, neighbours, goal,
+               [](const State &) { return Cost(0); });
+}
+
+// Unit weights: emit(t) for every edge s -> t, and costs count the steps.
+template <typename States, typename State, typename Neighbours,
+          typename Goal = NoGoal>
+std::optional<State> bfs(States *states, const State &source,
+                         Neighbours neighbours, Goal goal = Goal()) {
+  using Cost = typename States::cost_type;
+  states->improve(source, Cost(0), source);
+
+  std::vector<State> queue{source};
+  for (size_t head = 0; head < queue.size(); head++) {
+    const State s = queue[head];
+    if (goal(s)) {
+      return s;
+    }
+    const Cost next = states->cost(s) + 1;
+    neighbours(s, [&](const State &t) {
+      if (!states->improve(t, next, s)) {
+        return false;
+      }
+      queue.push_back(t);
+      return true;
+    });
+  }
+  return std::nullopt;
+}
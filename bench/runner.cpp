@@ -0,0 +1,430 @@
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <linux/perf_event.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Benchmark runner for solutions built as entry points by bench/Makefile.
+// There, each solution's main() is compiled as solution_main() into
+// build/<path>.so, which is loaded here with dlopen(). Every run is a
+// fork() of the runner, so that it starts from fresh globals, with stdin
+// from the input file, stdout to /dev/null, and the working directory in
+// the year's directory, as with `make 18/numbers && ./a.out < 18/in`.
+//
+// For each solution, over the measured runs (after the warm-up ones): the
+// min, median and p99 of the wall time, the median user + system CPU time,
+// the peak RSS and the median instructions retired, from perf_event_open
+// ("-" where the kernel has no hardware counters). With -o, the same goes
+// to a JSON file, to compare commits.
+//
+// Usage: make -C bench && bench/runner [-n runs] [-w warmup] [-t timeout_s]
+//            [-o out.json] 2021/18/numbers.cpp[:input] ...
+// Solutions are given by their source, relative to the repository; the
+// input is relative to the solution's directory and defaults to `in`.
+
+using Clock = std::chrono::steady_clock;
+
+struct Sample {
+  int64_t wall_ns;
+  int64_t cpu_ns;
+  int64_t instructions;  // -1 if not counted
+  long max_rss_kb;
+  int exit_code;
+};
+
+struct Result {
+  std::string name;
+  std::string input;
+  std::vector<Sample> samples;
+  std::string error;  // why the runs stopped, if they did
+};
+
+// An entry point: main() is either int() or int(int, char **), and
+// solution_main() is mangled after it.
+struct Entry {
+  int (*no_args)() = nullptr;
+  int (*with_args)(int, char **) = nullptr;
+
+  int operator()(char *name) const {
+    char *argv[] = {name, nullptr};
+    return no_args ? no_args() : with_args(1, argv);
+  }
+};
+
+bool loadEntry(const std::string &so_path, Entry *entry, std::string *error) {
+  void *lib = dlopen(so_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (!lib) {
+    *error = dlerror();
+    return false;
+  }
+  entry->no_args = (int (*)())dlsym(lib, "_Z13solution_mainv");
+  entry->with_args = (int (*)(int, char **))dlsym(lib, "_Z13solution_mainiPPc");
+  if (!entry->no_args && !entry->with_args) {
+    *error = "no solution_main() in " + so_path;
+    return false;
+  }
+  return true;
+}
+
+int openInstructionCounter() {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.inherit = 1;  // threads the solution starts
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+int64_t cpuNanos(const rusage &ru) {
+  return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000000LL +
+         (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000LL;
+}
+
+// The run in progress, in the child.
+struct {
+  int result_fd;
+  int perf_fd;
+  Clock::time_point start;
+  int64_t cpu_start;
+} run;
+
+// Runs when the solution returns from main() or calls exit(), before the
+// destructors of its globals.
+void finishRun(int exit_code, void *) {
+  Sample s;
+  s.instructions = -1;
+  if (run.perf_fd >= 0) {
+    ioctl(run.perf_fd, PERF_EVENT_IOC_DISABLE, 0);
+    long long count;
+    if (read(run.perf_fd, &count, sizeof(count)) == sizeof(count)) {
+      s.instructions = count;
+    }
+  }
+  s.wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  Clock::now() - run.start)
+                  .count();
+  rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  s.cpu_ns = cpuNanos(ru) - run.cpu_start;
+  s.max_rss_kb = ru.ru_maxrss;
+  s.exit_code = exit_code;
+  if (write(run.result_fd, &s, sizeof(s)) != sizeof(s)) {
+    _exit(127);
+  }
+}
+
+// Forks and runs the solution once. Returns false, with the reason in
+// *error, if it crashed or timed out.
+bool runOnce(const Entry &entry, const std::string &name,
+             const std::string &dir, const std::string &input,
+             int timeout_s, Sample *sample, std::string *error) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    *error = strerror(errno);
+    return false;
+  }
+  fflush(stdout);
+  fflush(stderr);
+  const pid_t pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    const int in = open(input.c_str(), O_RDONLY);
+    const int null = open("/dev/null", O_WRONLY);
+    if (in < 0 || null < 0 || chdir(dir.c_str()) != 0) {
+      _exit(126);
+    }
+    dup2(in, 0);
+    dup2(null, 1);
+    run.result_fd = fds[1];
+    run.perf_fd = openInstructionCounter();
+    on_exit(finishRun, nullptr);
+
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    run.cpu_start = cpuNanos(ru);
+    run.start = Clock::now();
+    if (run.perf_fd >= 0) {
+      ioctl(run.perf_fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(run.perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    std::string argv0 = name;
+    exit(entry(&argv0[0]));
+  }
+  close(fds[1]);
+  if (pid < 0) {
+    close(fds[0]);
+    *error = strerror(errno);
+    return false;
+  }
+
+  pollfd p{fds[0], POLLIN, 0};
+  const int timeout_ms = timeout_s > 0 ? timeout_s * 1000 : -1;
+  bool timed_out = poll(&p, 1, timeout_ms) == 0;
+  if (timed_out) {
+    kill(pid, SIGKILL);
+  }
+  const bool got_sample =
+      !timed_out && read(fds[0], sample, sizeof(*sample)) == sizeof(*sample);
+  close(fds[0]);
+  int status;
+  waitpid(pid, &status, 0);
+
+  if (timed_out) {
+    *error = "timed out after " + std::to_string(timeout_s) + " s";
+  } else if (WIFSIGNALED(status)) {
+    *error = std::string("killed by ") + strsignal(WTERMSIG(status));
+  } else if (!got_sample) {
+    *error = "exited with " + std::to_string(WEXITSTATUS(status)) +
+             " before the run finished";
+  }
+  return error->empty();
+}
+
+// Nearest-rank percentile of sorted values.
+int64_t percentile(const std::vector<int64_t> &sorted, double p) {
+  assert(!sorted.empty());
+  size_t rank = (size_t)(p / 100 * sorted.size() + 0.999999);
+  return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+}
+
+template <typename F>
+std::vector<int64_t> sortedField(const Result &r, F field) {
+  std::vector<int64_t> v;
+  for (const Sample &s : r.samples) {
+    v.push_back(field(s));
+  }
+  std::sort(v.begin(), v.end());
+  return v;
+}
+
+struct Stats {
+  int64_t wall_min, wall_median, wall_p99;
+  int64_t cpu_median;
+  long max_rss_kb;
+  int64_t instructions_median;  // -1 if not counted
+  int exit_code;                // of the last run
+};
+
+Stats stats(const Result &r) {
+  Stats st;
+  auto wall = sortedField(r, [](const Sample &s) { return s.wall_ns; });
+  st.wall_min = wall.front();
+  st.wall_median = percentile(wall, 50);
+  st.wall_p99 = percentile(wall, 99);
+  st.cpu_median =
+      percentile(sortedField(r, [](const Sample &s) { return s.cpu_ns; }), 50);
+  st.max_rss_kb = 0;
+  for (const Sample &s : r.samples) {
+    st.max_rss_kb = std::max(st.max_rss_kb, s.max_rss_kb);
+  }
+  st.instructions_median = percentile(
+      sortedField(r, [](const Sample &s) { return s.instructions; }), 50);
+  st.exit_code = r.samples.back().exit_code;
+  return st;
+}
+
+void printTable(const std::vector<Result> &results) {
+  printf("%-34s %5s %10s %10s %10s %10s %8s %14s\n", "solution", "runs",
+         "min ms", "median ms", "p99 ms", "cpu ms", "rss MB", "instructions");
+  for (const Result &r : results) {
+    if (r.samples.empty()) {
+      printf("%-34s %s\n", r.name.c_str(), r.error.c_str());
+      continue;
+    }
+    const Stats st = stats(r);
+    char instructions[32] = "-";
+    if (st.instructions_median >= 0) {
+      snprintf(instructions, sizeof(instructions), "%lld",
+               (long long)st.instructions_median);
+    }
+    printf("%-34s %5zu %10.3f %10.3f %10.3f %10.3f %8.1f %14s", r.name.c_str(),
+           r.samples.size(), st.wall_min / 1e6, st.wall_median / 1e6,
+           st.wall_p99 / 1e6, st.cpu_median / 1e6, st.max_rss_kb / 1024.0,
+           instructions);
+    if (!r.error.empty()) {
+      printf("  (%s)", r.error.c_str());
+    }
+    printf("\n");
+  }
+}
+
+std::string jsonString(const std::string &s) {
+  std::string out = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if ((unsigned char)c < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      out += buf;
+    } else {
+      out += c;
+    }
+  }
+  return out + "\"";
+}
+
+std::string gitCommit(const std::string &root) {
+  std::string cmd = "git -C '" + root + "' rev-parse HEAD 2>/dev/null";
+  FILE *git = popen(cmd.c_str(), "r");
+  if (!git) {
+    return "";
+  }
+  char buf[64] = "";
+  if (!fgets(buf, sizeof(buf), git)) {
+    buf[0] = 0;
+  }
+  pclose(git);
+  buf[strcspn(buf, "\n")] = 0;
+  return buf;
+}
+
+bool writeJson(const char *path, const std::string &commit, int runs,
+               int warmup, const std::vector<Result> &results) {
+  FILE *f = fopen(path, "w");
+  if (!f) {
+    return false;
+  }
+  fprintf(f, "{\n  \"commit\": %s,\n", jsonString(commit).c_str());
+  fprintf(f, "  \"runs\": %d,\n  \"warmup\": %d,\n", runs, warmup);
+  fprintf(f, "  \"solutions\": [");
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result &r = results[i];
+    fprintf(f, "%s\n    {\n", i ? "," : "");
+    fprintf(f, "      \"name\": %s,\n", jsonString(r.name).c_str());
+    fprintf(f, "      \"input\": %s,\n", jsonString(r.input).c_str());
+    fprintf(f, "      \"runs\": %zu,\n", r.samples.size());
+    if (!r.samples.empty()) {
+      const Stats st = stats(r);
+      fprintf(f,
+              "      \"wall_ns\": {\"min\": %lld, \"median\": %lld, "
+              "\"p99\": %lld},\n",
+              (long long)st.wall_min, (long long)st.wall_median,
+              (long long)st.wall_p99);
+      fprintf(f, "      \"cpu_ns_median\": %lld,\n",
+              (long long)st.cpu_median);
+      fprintf(f, "      \"peak_rss_kb\": %ld,\n", st.max_rss_kb);
+      if (st.instructions_median >= 0) {
+        fprintf(f, "      \"instructions_median\": %lld,\n",
+                (long long)st.instructions_median);
+      } else {
+        fprintf(f, "      \"instructions_median\": null,\n");
+      }
+      fprintf(f, "      \"exit_code\": %d,\n", st.exit_code);
+    }
+    fprintf(f, "      \"error\": %s\n    }",
+            r.error.empty() ? "null" : jsonString(r.error).c_str());
+  }
+  fprintf(f, "\n  ]\n}\n");
+  return fclose(f) == 0;
+}
+
+std::string dirName(const std::string &path) {
+  size_t slash = path.rfind('/');
+  return slash == std::string::npos ? "." : path.substr(0, slash);
+}
+
+int main(int argc, char *argv[]) {
+  int runs = 10;
+  int warmup = 1;
+  int timeout_s = 60;
+  const char *json_path = nullptr;
+  for (int opt; (opt = getopt(argc, argv, "n:w:t:o:")) != -1;) {
+    switch (opt) {
+      case 'n':
+        runs = atoi(optarg);
+        break;
+      case 'w':
+        warmup = atoi(optarg);
+        break;
+      case 't':
+        timeout_s = atoi(optarg);
+        break;
+      case 'o':
+        json_path = optarg;
+        break;
+      default:
+        return 2;
+    }
+  }
+  if (optind == argc || runs < 1 || warmup < 0) {
+    fprintf(stderr,
+            "usage: %s [-n runs] [-w warmup] [-t timeout_s] [-o out.json] "
+            "<year/day/solution.cpp[:input]> ...\n",
+            argv[0]);
+    return 2;
+  }
+
+  // The runner lives in <root>/bench, next to build/.
+  char self[PATH_MAX];
+  if (!realpath(argv[0], self)) {
+    perror(argv[0]);
+    return 1;
+  }
+  const std::string bench_dir = dirName(self);
+  const std::string root = dirName(bench_dir);
+
+  std::vector<Result> results;
+  for (int i = optind; i < argc; i++) {
+    std::string spec = argv[i];
+    std::string input = "in";
+    if (size_t colon = spec.find(':'); colon != std::string::npos) {
+      input = spec.substr(colon + 1);
+      spec = spec.substr(0, colon);
+    }
+    Result r;
+    r.name = argv[i];
+    const std::string source_dir = root + "/" + dirName(spec);
+    r.input = dirName(spec) + "/" + input;
+
+    // 2021/18/numbers.cpp: build/2021/18/numbers.so, run in 2021/
+    const std::string so_path =
+        bench_dir + "/build/" + spec.substr(0, spec.rfind('.')) + ".so";
+    Entry entry;
+    if (!loadEntry(so_path, &entry, &r.error)) {
+      results.push_back(r);
+      continue;
+    }
+    for (int k = 0; k < warmup + runs; k++) {
+      Sample s;
+      if (!runOnce(entry, spec, dirName(source_dir), source_dir + "/" + input,
+                   timeout_s, &s, &r.error)) {
+        break;
+      }
+      if (k >= warmup) {
+        r.samples.push_back(s);
+      }
+    }
+    results.push_back(r);
+  }
+
+  printTable(results);
+  if (json_path &&
+      !writeJson(json_path, gitCommit(root), runs, warmup, results)) {
+    perror(json_path);
+    return 1;
+  }
+  return 0;
+}